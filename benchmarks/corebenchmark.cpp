@@ -0,0 +1,296 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "corpusgenerator.h"
+#include "flatresultsmodel.h"
+#include "kernel.h"
+#include "mainwindow.h"
+#include "syntaxhighlighter.h"
+
+#include <QApplication>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTextDocument>
+#include <QtTest>
+
+// Micro-benchmarks of the hot paths, against a generated corpus.
+// Size it with the SNIPPY_CORPUS_* variables, see CorpusGenerator::Options::fromEnvironment().
+
+enum {
+    LoadTimeoutMs = 10 * 60 * 1000
+};
+
+static bool loadAndWait(SnippetModel *model)
+{
+    QSignalSpy spy(model, &SnippetModel::loaded);
+    model->load();
+    return spy.wait(LoadTimeoutMs);
+}
+
+static void collectSnippets(const QAbstractItemModel *model, const QModelIndex &parent, QVector<Snippet *> &snippets)
+{
+    for (int row = 0, count = model->rowCount(parent); row < count; ++row) {
+        const QModelIndex index = model->index(row, 0, parent);
+        if (auto snippet = index.data(SnippetModel::SnippetRole).value<Snippet *>())
+            snippets.append(snippet);
+        else
+            collectSnippets(model, index, snippets);
+    }
+}
+
+static int countAccepted(const SnippetProxyModel *proxy, const QAbstractItemModel *source, const QModelIndex &parent)
+{
+    int accepted = 0;
+    for (int row = 0, count = source->rowCount(parent); row < count; ++row) {
+        if (proxy->filterAcceptsRow(row, parent)) {
+            ++accepted;
+            accepted += countAccepted(proxy, source, source->index(row, 0, parent));
+        }
+    }
+
+    return accepted;
+}
+
+class CoreBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+
+    void loadFromFile();
+    void saveToFile();
+    void modelLoad();
+    void filter_data();
+    void filter();
+    void filterAcceptsRow_data();
+    void filterAcceptsRow();
+    void flatResults();
+    void sort_data();
+    void sort();
+    void highlightBlock();
+    void setSnippet();
+
+private:
+    QTemporaryDir m_corpusDir;
+    QTemporaryDir m_scratchDir;
+    Kernel *m_kernel = nullptr;
+    QVector<Snippet *> m_snippets;
+};
+
+void CoreBenchmark::initTestCase()
+{
+    QVERIFY(m_corpusDir.isValid());
+    QVERIFY(m_scratchDir.isValid());
+
+    const CorpusGenerator::Options options = CorpusGenerator::Options::fromEnvironment();
+    qInfo().noquote() << "Corpus:" << options.toString();
+    QVERIFY(CorpusGenerator(options).generate(m_corpusDir.path()));
+
+    qputenv("SNIPPY_FOLDER", m_corpusDir.path().toUtf8());
+    m_kernel = new Kernel(this);
+    QVERIFY(loadAndWait(m_kernel->model()));
+    collectSnippets(m_kernel->model(), QModelIndex(), m_snippets);
+    QCOMPARE(m_snippets.size(), options.snippets);
+}
+
+void CoreBenchmark::loadFromFile()
+{
+    const QFileInfo info(m_snippets.first()->absolutePath());
+    PathNode folder(info.absolutePath());
+    Snippet snippet(&folder, info.fileName());
+
+    QBENCHMARK {
+        snippet.loadFromFile();
+    }
+}
+
+void CoreBenchmark::saveToFile()
+{
+    // On a copy, so the corpus stays as generated
+    const QString copy = m_scratchDir.filePath(QStringLiteral("copy.snip"));
+    QVERIFY(QFile::copy(m_snippets.first()->absolutePath(), copy));
+    PathNode folder(m_scratchDir.path());
+    Snippet snippet(&folder, QStringLiteral("copy.snip"));
+
+    QBENCHMARK {
+        QVERIFY(snippet.saveToFile());
+    }
+}
+
+void CoreBenchmark::modelLoad()
+{
+    SnippetModel model;
+    QBENCHMARK {
+        QVERIFY(loadAndWait(&model));
+    }
+}
+
+void CoreBenchmark::filter_data()
+{
+    QTest::addColumn<QString>("expression");
+    QTest::addColumn<bool>("deepSearch");
+
+    QTest::newRow("simple") << "alpha" << false;
+    QTest::newRow("simple, deep") << "alpha" << true;
+    QTest::newRow("compound") << "alpha & (git | !cmake)" << false;
+    QTest::newRow("compound, deep") << "alpha & (git | !cmake)" << true;
+    QTest::newRow("tag") << "tag1" << false;
+    QTest::newRow("qualified") << "tag:tag1 & title:alpha" << false;
+    QTest::newRow("body after tag") << "body:git & tag:tag1" << false; // The planner runs the tag first
+    QTest::newRow("glob") << "alpha*" << false;
+    QTest::newRow("regex, deep") << "/^(git|cmake) [a-z]+/" << true;
+}
+
+void CoreBenchmark::filter()
+{
+    QFETCH(QString, expression);
+    QFETCH(bool, deepSearch);
+
+    SnippetProxyModel *proxy = m_kernel->filterModel();
+    proxy->setIsDeepSearch(deepSearch);
+
+    // A full pass, recomputing the matches and re-filtering the proxy
+    QBENCHMARK {
+        proxy->setFilterText(QString());
+        proxy->setFilterText(expression);
+    }
+
+    proxy->setFilterText(QString());
+    proxy->setIsDeepSearch(false);
+}
+
+void CoreBenchmark::filterAcceptsRow_data()
+{
+    filter_data();
+}
+
+void CoreBenchmark::filterAcceptsRow()
+{
+    QFETCH(QString, expression);
+    QFETCH(bool, deepSearch);
+
+    SnippetProxyModel *proxy = m_kernel->filterModel();
+    proxy->setIsDeepSearch(deepSearch);
+    proxy->setFilterText(expression);
+
+    // Just the per-row answers, as asked by QSortFilterProxyModel when mapping
+    int accepted = 0;
+    QBENCHMARK {
+        accepted = countAccepted(proxy, m_kernel->model(), QModelIndex());
+    }
+    QVERIFY(accepted > 0);
+
+    proxy->setFilterText(QString());
+    proxy->setIsDeepSearch(false);
+}
+
+void CoreBenchmark::flatResults()
+{
+    SnippetProxyModel *proxy = m_kernel->filterModel();
+    proxy->setFilterText(QStringLiteral("alpha | git"));
+    FlatResultsModel model(proxy);
+
+    // Listing every match from scratch, what switching to the flat view costs
+    QBENCHMARK {
+        model.setActive(false);
+        model.setActive(true);
+    }
+    QVERIFY(model.rowCount() > 0);
+
+    proxy->setFilterText(QString());
+}
+
+void CoreBenchmark::sort_data()
+{
+    QTest::addColumn<int>("order");
+
+    QTest::newRow("title") << int(SnippetProxyModel::TitleOrder);
+    QTest::newRow("modified") << int(SnippetProxyModel::ModifiedOrder);
+    QTest::newRow("score") << int(SnippetProxyModel::ScoreOrder);
+}
+
+void CoreBenchmark::sort()
+{
+    QFETCH(int, order);
+
+    SnippetProxyModel *proxy = m_kernel->filterModel();
+    proxy->setFilterText(QStringLiteral("alpha | git"));
+
+    // Sorting the whole tree again, title keys are only computed by the first iteration
+    QBENCHMARK {
+        proxy->setSortOrder(SnippetProxyModel::FolderOrder);
+        proxy->setSortOrder(SnippetProxyModel::SortOrder(order));
+    }
+
+    proxy->setSortOrder(SnippetProxyModel::FolderOrder);
+    proxy->setFilterText(QString());
+}
+
+void CoreBenchmark::highlightBlock()
+{
+    Snippet *largest = m_snippets.first();
+    foreach (Snippet *snippet, m_snippets) {
+        if (snippet->contents().size() > largest->contents().size())
+            largest = snippet;
+    }
+
+    QTextDocument document;
+    document.setPlainText(largest->contents());
+    SyntaxHighlighter highlighter(&document);
+    const FilterQuery query(QStringLiteral("alpha | git | tag1"));
+    const QVector<MatchSpan> spans = FilterQuery::matchSpans(query.positiveTerms(), largest->contents());
+    highlighter.setSpans(spans);
+
+    QBENCHMARK {
+        highlighter.rehighlight();
+    }
+}
+
+void CoreBenchmark::setSnippet()
+{
+    // The window has its own Kernel, which loads the corpus again. Its snippets are the ones to show.
+    MainWindow window(QString());
+    QSignalSpy loadedSpy(window.m_kernel.model(), &SnippetModel::loaded);
+    QVERIFY(loadedSpy.wait(LoadTimeoutMs));
+
+    QVector<Snippet *> snippets;
+    collectSnippets(window.m_kernel.model(), QModelIndex(), snippets);
+    QVERIFY(!snippets.isEmpty());
+
+    int i = 0;
+    QBENCHMARK {
+        window.setSnippet(snippets.at(i++ % snippets.size()));
+    }
+    window.setSnippet(nullptr);
+}
+
+int main(int argc, char **argv)
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    CoreBenchmark benchmark;
+    return QTest::qExec(&benchmark, argc, argv);
+}
+
+#include "corebenchmark.moc"
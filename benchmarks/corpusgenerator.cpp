@@ -0,0 +1,173 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "corpusgenerator.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QRandomGenerator>
+
+#include <algorithm>
+#include <cmath>
+
+static int envInt(const char *name, int defaultValue)
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+CorpusGenerator::Options CorpusGenerator::Options::fromEnvironment(Options options)
+{
+    options.snippets = envInt("SNIPPY_CORPUS_SNIPPETS", options.snippets);
+    options.depth = envInt("SNIPPY_CORPUS_DEPTH", options.depth);
+    options.fanout = envInt("SNIPPY_CORPUS_FANOUT", options.fanout);
+    options.bodyBytes = envInt("SNIPPY_CORPUS_BODY_BYTES", options.bodyBytes);
+    options.vocabulary = envInt("SNIPPY_CORPUS_VOCABULARY", options.vocabulary);
+    options.tagsPerSnippet = envInt("SNIPPY_CORPUS_TAGS_PER_SNIPPET", options.tagsPerSnippet);
+    options.seed = quint32(envInt("SNIPPY_CORPUS_SEED", int(options.seed)));
+    if (qEnvironmentVariableIsSet("SNIPPY_CORPUS_TAG_SKEW"))
+        options.tagSkew = qgetenv("SNIPPY_CORPUS_TAG_SKEW").toDouble();
+
+    return options;
+}
+
+QString CorpusGenerator::Options::toString() const
+{
+    return QStringLiteral("snippets=%1 depth=%2 fanout=%3 bodyBytes=%4 vocabulary=%5 tagsPerSnippet=%6 tagSkew=%7 seed=%8")
+        .arg(snippets)
+        .arg(depth)
+        .arg(fanout)
+        .arg(bodyBytes)
+        .arg(vocabulary)
+        .arg(tagsPerSnippet)
+        .arg(tagSkew)
+        .arg(seed);
+}
+
+CorpusGenerator::CorpusGenerator(const Options &options)
+    : m_options(options)
+{
+    double sum = 0;
+    for (int rank = 1; rank <= qMax(1, m_options.vocabulary); ++rank) {
+        sum += 1.0 / std::pow(rank, m_options.tagSkew);
+        m_tagCdf.append(sum);
+    }
+
+    for (double &p : m_tagCdf)
+        p /= sum;
+}
+
+QStringList CorpusGenerator::words()
+{
+    return { "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel",
+             "india", "juliet", "kilo", "lima", "mike", "november", "oscar", "papa",
+             "quebec", "romeo", "sierra", "tango", "uniform", "victor", "whiskey", "xray",
+             "yankee", "zulu", "git", "cmake", "qt", "docker", "ssh", "grep",
+             "rebase", "cherry", "pick", "signal", "slot", "thread", "mutex", "socket",
+             "json", "regex", "python", "bash", "kernel", "model", "proxy", "index" };
+}
+
+QString CorpusGenerator::tag(double random) const
+{
+    const int rank = int(std::lower_bound(m_tagCdf.cbegin(), m_tagCdf.cend(), random) - m_tagCdf.cbegin());
+    return QStringLiteral("tag%1").arg(qMin(rank, m_tagCdf.size() - 1));
+}
+
+QStringList CorpusGenerator::folderPaths(const QString &rootPath) const
+{
+    // Level by level. Snippets go to every folder below the root, or to the root if there are none.
+    QStringList all;
+    QStringList level = { rootPath };
+    for (int depth = 1; depth <= m_options.depth; ++depth) {
+        QStringList next;
+        for (const QString &parent : level) {
+            for (int i = 0; i < m_options.fanout; ++i)
+                next << QStringLiteral("%1/d%2_%3").arg(parent).arg(depth).arg(i);
+        }
+        all += next;
+        level = next;
+    }
+
+    return all.isEmpty() ? QStringList { rootPath } : all;
+}
+
+bool CorpusGenerator::generate(const QString &rootPath)
+{
+    QRandomGenerator random(m_options.seed);
+    const QStringList wordList = words();
+    auto word = [&random, &wordList] {
+        return wordList.at(int(random.bounded(wordList.size())));
+    };
+
+    const QStringList folders = folderPaths(rootPath);
+    QVector<int> depths;
+    for (const QString &folder : folders) {
+        if (!QDir().mkpath(folder)) {
+            qWarning() << Q_FUNC_INFO << "Failed to create" << folder;
+            return false;
+        }
+        depths.append(folder.count(QLatin1Char('/')) - rootPath.count(QLatin1Char('/')));
+    }
+
+    m_totalDepth = 0;
+
+    for (int i = 0; i < m_options.snippets; ++i) {
+        // One call per statement, argument evaluation order would make titles compiler dependent
+        QStringList titleWords;
+        for (int w = 0; w < 3; ++w)
+            titleWords << word();
+        const QString title = QStringLiteral("%1 %2").arg(titleWords.join(QLatin1Char(' '))).arg(i);
+
+        QStringList tags;
+        for (int t = 0; t < m_options.tagsPerSnippet; ++t) {
+            const QString tag = this->tag(random.generateDouble());
+            if (!tags.contains(tag))
+                tags << tag;
+        }
+
+        const int bodyBytes = m_options.bodyBytes / 2 + int(random.bounded(qMax(1, m_options.bodyBytes)));
+        QByteArray body;
+        body.reserve(bodyBytes + 16);
+        while (body.size() < bodyBytes) {
+            body += word().toUtf8();
+            body += random.bounded(8) == 0 ? '\n' : ' ';
+        }
+
+        m_totalDepth += depths.at(i % folders.size());
+        QFile file(QStringLiteral("%1/%2.snip").arg(folders.at(i % folders.size())).arg(i));
+        if (!file.open(QIODevice::WriteOnly)) {
+            qWarning() << Q_FUNC_INFO << "Failed to write" << file.fileName() << file.errorString();
+            return false;
+        }
+
+        file.write(title.toUtf8() + '\n' + tags.join(QLatin1Char(';')).toUtf8() + '\n' + body + '\n');
+    }
+
+    return true;
+}
+
+qint64 CorpusGenerator::totalDepth() const
+{
+    return m_totalDepth;
+}
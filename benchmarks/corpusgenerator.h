@@ -0,0 +1,73 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_CORPUS_GENERATOR_H
+#define SNIPPY_CORPUS_GENERATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Writes a synthetic snippet folder, the same one for the same options.
+// Titles and bodies are drawn from a small word list so filters have predictable hits,
+// tags follow a Zipf distribution so a few are very common and most are rare.
+
+class CorpusGenerator
+{
+public:
+    struct Options
+    {
+        int snippets = 1000;
+        int depth = 3; // Folder levels below the root, 0 puts everything in the root
+        int fanout = 4; // Sub-folders per folder
+        int bodyBytes = 512; // Average, each body is between half and one and a half of this
+        int vocabulary = 200; // Distinct tags
+        int tagsPerSnippet = 3;
+        double tagSkew = 1.0; // Zipf exponent, 0 is uniform
+        quint32 seed = 1;
+
+        // Overrides from SNIPPY_CORPUS_SNIPPETS, _DEPTH, _FANOUT, _BODY_BYTES, _VOCABULARY,
+        // _TAGS_PER_SNIPPET, _TAG_SKEW and _SEED
+        static Options fromEnvironment(Options defaults = Options());
+        QString toString() const;
+    };
+
+    explicit CorpusGenerator(const Options &);
+
+    // rootPath must exist, returns false on I/O errors
+    bool generate(const QString &rootPath);
+
+    // Sum over all snippets of how many folders deep they are, after generate()
+    qint64 totalDepth() const;
+
+    static QStringList words(); // What titles and bodies are made of
+
+private:
+    QStringList folderPaths(const QString &rootPath) const;
+    QString tag(double random) const;
+
+    const Options m_options;
+    qint64 m_totalDepth = 0;
+    QVector<double> m_tagCdf; // Cumulative Zipf probabilities
+};
+
+#endif
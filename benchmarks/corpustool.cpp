@@ -0,0 +1,72 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "corpusgenerator.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+
+// Generates a corpus to point SNIPPY_FOLDER at, for measuring the real application
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generates a synthetic snippy corpus");
+    parser.addHelpOption();
+    parser.addPositionalArgument("folder", "Where to write the corpus, must not exist");
+    parser.addOption(QCommandLineOption("snippets", "Number of snippets", "n", "1000"));
+    parser.addOption(QCommandLineOption("depth", "Folder levels", "n", "3"));
+    parser.addOption(QCommandLineOption("fanout", "Sub-folders per folder", "n", "4"));
+    parser.addOption(QCommandLineOption("body-bytes", "Average body size", "n", "512"));
+    parser.addOption(QCommandLineOption("vocabulary", "Distinct tags", "n", "200"));
+    parser.addOption(QCommandLineOption("tags-per-snippet", "Tags per snippet", "n", "3"));
+    parser.addOption(QCommandLineOption("tag-skew", "Zipf exponent of the tag distribution", "s", "1.0"));
+    parser.addOption(QCommandLineOption("seed", "Random seed", "n", "1"));
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1)
+        parser.showHelp(1);
+
+    const QString folder = parser.positionalArguments().constFirst();
+    if (QDir(folder).exists()) {
+        qWarning() << folder << "already exists";
+        return 1;
+    }
+
+    CorpusGenerator::Options options;
+    options.snippets = parser.value("snippets").toInt();
+    options.depth = parser.value("depth").toInt();
+    options.fanout = parser.value("fanout").toInt();
+    options.bodyBytes = parser.value("body-bytes").toInt();
+    options.vocabulary = parser.value("vocabulary").toInt();
+    options.tagsPerSnippet = parser.value("tags-per-snippet").toInt();
+    options.tagSkew = parser.value("tag-skew").toDouble();
+    options.seed = parser.value("seed").toUInt();
+
+    if (!QDir().mkpath(folder))
+        return 1;
+
+    return CorpusGenerator(options).generate(folder) ? 0 : 1;
+}
@@ -0,0 +1,318 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "filterquery.h"
+
+#include <QCoreApplication>
+#include <QSet>
+#include <QThread>
+#include <QtTest>
+
+#include <functional>
+
+// The filter grammar, what its terms match and how the planner orders them
+
+class FilterQueryTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void parse_data();
+    void parse();
+    void errors_data();
+    void errors();
+    void evaluate_data();
+    void evaluate();
+    void termMatches_data();
+    void termMatches();
+    void positiveTerms();
+    void matchSpans();
+    void planOrder_data();
+    void planOrder();
+    void patternBudget();
+
+private:
+    static QString tree(const FilterQuery &);
+};
+
+QString FilterQueryTest::tree(const FilterQuery &query)
+{
+    // What explain() prints, as "&(a |(b c))". Children are indented by two spaces.
+    const QString explanation = query.explain();
+    const int start = explanation.indexOf(QLatin1String("\n\n"));
+    if (start == -1)
+        return QString();
+
+    QStringList labels;
+    QVector<int> depths;
+    foreach (const QString &line, explanation.mid(start + 2).split(QLatin1Char('\n'))) {
+        const int end = line.indexOf(QLatin1String("  est. cost"));
+        if (end == -1)
+            continue;
+
+        int indent = 0;
+        while (line.at(indent) == QLatin1Char(' '))
+            ++indent;
+        labels << line.mid(indent, end - indent).trimmed();
+        depths << indent / 2;
+    }
+
+    int pos = 0;
+    std::function<QString(int)> build = [&](int depth) {
+        const QString label = labels.at(pos++);
+        QStringList children;
+        while (pos < labels.size() && depths.at(pos) == depth + 1)
+            children << build(depth + 1);
+        return children.isEmpty() ? label : label + QLatin1Char('(') + children.join(QLatin1Char(' ')) + QLatin1Char(')');
+    };
+    return labels.isEmpty() ? QString() : build(0);
+}
+
+void FilterQueryTest::parse_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("term") << "a" << "a";
+    QTest::newRow("lower-cased") << "Docker" << "docker";
+    QTest::newRow("implicit and") << "a b" << "&(a b)";
+    QTest::newRow("and before or") << "a & b | c" << "|(&(a b) c)";
+    QTest::newRow("and before or, right") << "a | b c" << "|(a &(b c))";
+    QTest::newRow("doubled operators") << "a && b || c" << "|(&(a b) c)";
+    QTest::newRow("not binds tightest") << "!a b" << "&(!(a) b)";
+    QTest::newRow("double not") << "!!a" << "a";
+    QTest::newRow("not of a group") << "!(a | b)" << "!(|(a b))";
+    QTest::newRow("group next to a term") << "a (b | c)" << "&(a |(b c))";
+    QTest::newRow("flattened and") << "a & (b & c)" << "&(a b c)";
+    QTest::newRow("flattened or") << "(a | b) | c" << "|(a b c)";
+    QTest::newRow("quotes keep operators") << "\"foo | bar\" baz" << "&(\"foo | bar\" baz)";
+    QTest::newRow("qualifiers") << "title:Foo tag:k8s path:docker/ body:x :bin"
+                                << "&(title:foo tag:k8s path:docker body:x :bin)";
+    QTest::newRow("qualifier case") << "TITLE:foo" << "title:foo";
+    QTest::newRow("regex") << "/^kubectl (get|describe)/" << "/^kubectl (get|describe)/";
+    QTest::newRow("escaped slash") << "/a\\/b/ c" << "&(/a\\/b/ c)";
+    QTest::newRow("glob keeps case") << "Docker-*" << "Docker-*";
+    QTest::newRow("nested deep enough") << QString(64, QLatin1Char('(')) + "a" + QString(64, QLatin1Char(')')) << "a";
+}
+
+void FilterQueryTest::parse()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, expected);
+
+    const FilterQuery query(text);
+    QVERIFY2(query.isValid(), qPrintable(query.errorString()));
+    QVERIFY(!query.isEmpty());
+    QCOMPARE(tree(query), expected);
+}
+
+void FilterQueryTest::errors_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("error");
+
+    QTest::newRow("dangling and") << "a &" << "Expected a term at the end at column 4";
+    QTest::newRow("dangling not") << "a !" << "Expected a term at the end at column 4";
+    QTest::newRow("two operators") << "a & | b" << "Expected a term at column 5";
+    QTest::newRow("missing paren") << "(a" << "Missing ')' at column 3";
+    QTest::newRow("extra paren") << "a)" << "Unexpected ')' at column 2";
+    QTest::newRow("missing quote") << "a \"bc" << "Missing closing quote at column 3";
+    QTest::newRow("missing slash") << "/abc" << "Missing closing '/' at column 1";
+    QTest::newRow("escaped closing slash") << "/abc\\/" << "Missing closing '/' at column 1";
+    QTest::newRow("empty qualifier") << "a title:" << "Missing text after 'title:' at column 3";
+    QTest::newRow("invalid regex") << "/(/" << "Invalid pattern: ";
+    QTest::newRow("too deep") << QString(65, QLatin1Char('(')) + "a" + QString(65, QLatin1Char(')')) << "Too deeply nested at column 66";
+    QTest::newRow("too many nots") << QString(65, QLatin1Char('!')) + "a" << "Too deeply nested at column 66";
+}
+
+void FilterQueryTest::errors()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, error);
+
+    const FilterQuery query(text);
+    QVERIFY(!query.isValid());
+    QVERIFY(query.isEmpty()); // Nothing half-parsed to match with
+    QVERIFY2(query.errorString().startsWith(error), qPrintable(query.errorString()));
+}
+
+void FilterQueryTest::evaluate_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QStringList>("matching"); // Terms that match
+    QTest::addColumn<bool>("expected");
+
+    QTest::newRow("empty") << "  " << QStringList() << true;
+    QTest::newRow("and, both") << "a b" << QStringList({ "a", "b" }) << true;
+    QTest::newRow("and, one") << "a b" << QStringList({ "a" }) << false;
+    QTest::newRow("or, one") << "a | b" << QStringList({ "b" }) << true;
+    QTest::newRow("precedence, or side") << "a & b | c" << QStringList({ "c" }) << true;
+    QTest::newRow("precedence, and side") << "a | b & c" << QStringList({ "b" }) << false;
+    QTest::newRow("not") << "!a" << QStringList() << true;
+    QTest::newRow("not of a group") << "a !(b | c)" << QStringList({ "a", "c" }) << false;
+    QTest::newRow("double not") << "!!a" << QStringList({ "a" }) << true;
+}
+
+void FilterQueryTest::evaluate()
+{
+    QFETCH(QString, text);
+    QFETCH(QStringList, matching);
+    QFETCH(bool, expected);
+
+    const FilterQuery query(text);
+    QVERIFY(query.isValid());
+    const bool matched = query.matches([&matching](const FilterQuery::Term &term) {
+        return matching.contains(term.text);
+    });
+    QCOMPARE(matched, expected);
+}
+
+void FilterQueryTest::termMatches_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("value");
+    QTest::addColumn<bool>("expected");
+
+    QTest::newRow("plain is a substring") << "CTL" << "kubectl" << true;
+    QTest::newRow("folder glob") << ":docker-*" << "/docker-compose" << true;
+    QTest::newRow("folder glob, no slash") << ":docker-*" << "docker-compose" << true;
+    QTest::newRow("folder glob is anchored") << ":docker-*" << "/x/docker-compose" << false;
+    QTest::newRow("path glob") << "path:docker/*" << "/docker/compose" << true;
+    QTest::newRow("star crosses folders") << "path:*compose" << "/docker/compose" << true;
+    QTest::newRow("bare glob on a path") << "dock?r" << "/docker" << true;
+    QTest::newRow("title glob, whole title") << "title:dock?r" << "Docker" << true;
+    QTest::newRow("title glob, no slash") << "title:dock?r" << "/docker" << false;
+    QTest::newRow("body glob, per line") << "body:foo*" << "x\nfoobar\ny" << true;
+    QTest::newRow("regex") << "/^kubectl (get|describe)/" << "kubectl describe pod" << true;
+    QTest::newRow("regex, escaped slash") << "/a\\/b/" << "a/b" << true;
+    QTest::newRow("trailing slash dropped") << "path:docker/" << "/docker" << true;
+}
+
+void FilterQueryTest::termMatches()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, value);
+    QFETCH(bool, expected);
+
+    const FilterQuery query(text);
+    const QVector<FilterQuery::Term> terms = query.positiveTerms();
+    QCOMPARE(terms.size(), 1);
+    QCOMPARE(terms.first().matches(value), expected);
+}
+
+void FilterQueryTest::positiveTerms()
+{
+    const FilterQuery query("a & !b & (c | title:d) & !(e | f)");
+    const QVector<FilterQuery::Term> terms = query.positiveTerms();
+    QCOMPARE(terms.size(), 3);
+    QCOMPARE(terms.at(0).text, QStringLiteral("a"));
+    QCOMPARE(terms.at(1).text, QStringLiteral("c"));
+    QCOMPARE(terms.at(2).text, QStringLiteral("d"));
+    QCOMPARE(terms.at(2).field, FilterQuery::TitleField);
+    QVERIFY(FilterQuery().positiveTerms().isEmpty());
+}
+
+void FilterQueryTest::matchSpans()
+{
+    // Overlapping and touching spans are merged, the result is sorted
+    const QVector<FilterQuery::Term> terms = FilterQuery("kube ctl /ge./").positiveTerms();
+    const QVector<MatchSpan> spans = FilterQuery::matchSpans(terms, QStringLiteral("KUBECTL get kube"));
+    const QVector<MatchSpan> expected = { { 0, 7 }, { 8, 3 }, { 12, 4 } };
+    QCOMPARE(spans, expected);
+
+    QVERIFY(FilterQuery::matchSpans(terms, QStringLiteral("nothing")).isEmpty());
+}
+
+void FilterQueryTest::planOrder_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<int>("tagUsage"); // Of 100 snippets
+    QTest::addColumn<QString>("expected");
+
+    // Bodies can't be ruled out by a single letter, they go last
+    QTest::newRow("rare tag first") << "body:x title:foo tag:k8s" << 50 << "&(tag:k8s title:foo body:x)";
+    QTest::newRow("common tag after title") << "body:x title:foo tag:k8s" << 99 << "&(title:foo tag:k8s body:x)";
+    QTest::newRow("or, likely pass first") << "body:xyzw | title:a" << 0 << "|(title:a body:xyzw)";
+    QTest::newRow("nested") << "body:x (title:foo | tag:k8s)" << 50 << "&(|(tag:k8s title:foo) body:x)";
+}
+
+void FilterQueryTest::planOrder()
+{
+    QFETCH(QString, text);
+    QFETCH(int, tagUsage);
+    QFETCH(QString, expected);
+
+    FilterQuery query(text);
+    FilterQuery::Statistics statistics;
+    statistics.snippetCount = 100;
+    statistics.tagUsage = [tagUsage](const FilterQuery::Term &) {
+        return tagUsage;
+    };
+    query.plan(statistics);
+    QCOMPARE(tree(query), expected);
+
+    // Planning doesn't change the result
+    const QSet<QString> matching = { QStringLiteral("x"), QStringLiteral("foo") };
+    auto matcher = [&matching](const FilterQuery::Term &term) {
+        return matching.contains(term.text);
+    };
+    QCOMPARE(query.matches(matcher), FilterQuery(text).matches(matcher));
+}
+
+void FilterQueryTest::patternBudget()
+{
+    // Only the matching counts, however long the matcher takes otherwise
+    FilterQuery slow(QStringLiteral("/a/"));
+    slow.startPass(1);
+    for (int i = 0; i < 3; ++i) {
+        QVERIFY(slow.matches([](const FilterQuery::Term &term) {
+            QThread::msleep(5); // Like reading a body from disk
+            return FilterQuery::matchPattern(term.pattern, QStringLiteral("a"));
+        }));
+    }
+    QVERIFY(!slow.timedOut());
+
+    // Once over budget patterns match nothing, plain terms still run
+    FilterQuery query(QStringLiteral("/a/ | b"));
+    query.startPass(0);
+    auto matcher = [](const FilterQuery::Term &term) {
+        return term.isPattern() ? FilterQuery::matchPattern(term.pattern, QStringLiteral("a")) : term.text == QLatin1String("b");
+    };
+    QVERIFY(query.matches(matcher)); // Within the budget when it started
+    QVERIFY(query.timedOut());
+    QVERIFY(query.matches(matcher)); // Through "b"
+    QVERIFY(!FilterQuery(QStringLiteral("/a/")).timedOut());
+
+    // Explain only shows times while timing
+    QVERIFY(!query.explain().contains(QLatin1String(" ms\n")));
+    query.setTimingEnabled(true);
+    query.matches(matcher);
+    QVERIFY(query.explain().contains(QLatin1String(" ms\n")));
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    FilterQueryTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "filterquerytest.moc"
@@ -0,0 +1,190 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "corpusgenerator.h"
+#include "mainwindow.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <algorithm>
+#include <cstdio>
+
+// Drives a real MainWindow on the offscreen platform and measures what users wait for:
+// from a key press or click until the results are painted.
+// Prints p50/p95/p99 per interaction as JSON, to stdout or to the file given as argument.
+// Size the corpus with SNIPPY_CORPUS_*, the number of rounds with SNIPPY_LATENCY_ROUNDS.
+
+class LatencyHarness
+{
+public:
+    // Before the window is shown, so the load can't finish unnoticed
+    explicit LatencyHarness(MainWindow *window)
+        : m_window(window)
+        , m_loadedSpy(window->m_kernel.model(), &SnippetModel::loaded)
+    {
+    }
+
+    bool waitForLoaded()
+    {
+        return !m_loadedSpy.isEmpty() || m_loadedSpy.wait(10 * 60 * 1000);
+    }
+
+    // Each key is one sample. The debounce isn't waited for, the filter runs as if it expired.
+    void type(const QString &text)
+    {
+        for (const QChar c : text) {
+            measure(QStringLiteral("keystroke"), [this, c] {
+                QTest::keyClick(m_window->m_filterLineEdit, c.toLatin1());
+                applyFilterNow();
+            });
+        }
+    }
+
+    void clearFilter()
+    {
+        while (!m_window->m_filterLineEdit->text().isEmpty()) {
+            measure(QStringLiteral("backspace"), [this] {
+                QTest::keyClick(m_window->m_filterLineEdit, Qt::Key_Backspace);
+                applyFilterNow();
+            });
+        }
+    }
+
+    void toggleDeepSearch()
+    {
+        measure(QStringLiteral("deep_search_toggle"), [this] {
+            m_window->m_deepSearchCB->click();
+            paint(m_window->m_treeView);
+        });
+    }
+
+    void arrowDown(int count)
+    {
+        for (int i = 0; i < count; ++i) {
+            measure(QStringLiteral("arrow_down"), [this] {
+                QTest::keyClick(m_window->m_treeView, Qt::Key_Down);
+                paint(m_window->m_textEdit);
+            });
+        }
+    }
+
+    QJsonObject results() const
+    {
+        QJsonObject result;
+        for (auto it = m_samples.cbegin(), end = m_samples.cend(); it != end; ++it) {
+            QVector<double> sorted = it.value();
+            std::sort(sorted.begin(), sorted.end());
+            auto percentile = [&sorted](int p) {
+                return sorted.at(qMin(sorted.size() - 1, sorted.size() * p / 100));
+            };
+            result.insert(it.key(), QJsonObject { { "count", sorted.size() },
+                                                  { "p50_ms", percentile(50) },
+                                                  { "p95_ms", percentile(95) },
+                                                  { "p99_ms", percentile(99) },
+                                                  { "max_ms", sorted.last() } });
+        }
+
+        return result;
+    }
+
+private:
+    void applyFilterNow()
+    {
+        m_window->m_scheduleFilterTimer.stop();
+        m_window->updateFilter();
+        paint(m_window->m_treeView);
+    }
+
+    static void paint(QAbstractScrollArea *area)
+    {
+        QCoreApplication::processEvents();
+        area->viewport()->repaint();
+    }
+
+    template<typename F>
+    void measure(const QString &interaction, F f)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        f();
+        m_samples[interaction].append(timer.nsecsElapsed() / 1000000.0);
+    }
+
+    MainWindow *const m_window;
+    QSignalSpy m_loadedSpy;
+    QMap<QString, QVector<double>> m_samples; // In ms
+};
+
+int main(int argc, char **argv)
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+
+    QTemporaryDir corpusDir;
+    const CorpusGenerator::Options options = CorpusGenerator::Options::fromEnvironment();
+    if (!corpusDir.isValid() || !CorpusGenerator(options).generate(corpusDir.path()))
+        return 1;
+
+    qputenv("SNIPPY_FOLDER", corpusDir.path().toUtf8());
+    MainWindow window(QString());
+    LatencyHarness harness(&window);
+    window.show();
+    if (!QTest::qWaitForWindowExposed(&window) || !harness.waitForLoaded())
+        return 1;
+
+    bool ok = false;
+    const int rounds = qEnvironmentVariableIntValue("SNIPPY_LATENCY_ROUNDS", &ok);
+    const QStringList scripts = { "alpha", "git & ssh", "tag1", "qt | cmake", "zulu" };
+    for (int round = 0; round < (ok ? rounds : 5); ++round) {
+        for (const QString &script : scripts) {
+            harness.type(script);
+            harness.arrowDown(10);
+            harness.toggleDeepSearch();
+            harness.arrowDown(5);
+            harness.toggleDeepSearch();
+            harness.clearFilter();
+        }
+    }
+
+    const QJsonObject report { { "corpus", options.toString() }, { "interactions", harness.results() } };
+    const QByteArray json = QJsonDocument(report).toJson();
+    if (argc > 1) {
+        QFile file(QString::fromLocal8Bit(argv[1]));
+        if (!file.open(QIODevice::WriteOnly))
+            return 1;
+        file.write(json);
+    } else {
+        fputs(json.constData(), stdout);
+    }
+
+    return 0;
+}
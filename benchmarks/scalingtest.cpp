@@ -0,0 +1,189 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "corpusgenerator.h"
+#include "snippetmodel.h"
+#include "snippetproxymodel.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <cmath>
+#include <limits>
+
+// Loads and filters trees of growing size in three extreme shapes, fits log(time) against
+// log(work) and fails if an operation grows clearly worse than linear.
+// The work is the summed folder depth of all snippets, paths being read and matched is
+// inherently proportional to that, so a deep tree isn't expected to be linear in its snippets.
+// SNIPPY_SCALING_SIZES overrides the snippet counts, comma separated.
+
+enum {
+    LoadTimeoutMs = 10 * 60 * 1000,
+    LoadRepeats = 3,
+    FilterRepeats = 5,
+    SnippetsPerFolder = 10
+};
+
+static const double MaxSlope = 1.3; // Some slack for cache effects, quadratic is 2
+
+struct Sample
+{
+    qint64 work = 0;
+    qint64 loadNs = 0;
+    qint64 filterNs = 0;
+};
+
+// Least-squares slope of log(y) over log(x)
+static double logLogSlope(const QVector<Sample> &samples, qint64 Sample::*member)
+{
+    const int n = samples.size();
+    double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+    for (const Sample &sample : samples) {
+        const double x = std::log(double(sample.work));
+        const double y = std::log(double(qMax<qint64>(1, sample.*member)));
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+    }
+
+    const double denominator = n * sumXX - sumX * sumX;
+    return denominator == 0 ? 0 : (n * sumXY - sumX * sumY) / denominator;
+}
+
+static QVector<int> sizes()
+{
+    QVector<int> result;
+    const QStringList values = QString::fromLocal8Bit(qgetenv("SNIPPY_SCALING_SIZES")).split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &value : values) {
+        if (value.toInt() > 0)
+            result << value.toInt();
+    }
+
+    return result.isEmpty() ? QVector<int> { 1000, 2000, 4000, 8000 } : result;
+}
+
+class ScalingTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void scaling_data();
+    void scaling();
+};
+
+void ScalingTest::scaling_data()
+{
+    QTest::addColumn<QString>("shape");
+    QTest::newRow("wide-flat") << "wide-flat";
+    QTest::newRow("deep-narrow") << "deep-narrow";
+    QTest::newRow("balanced") << "balanced";
+}
+
+void ScalingTest::scaling()
+{
+    QFETCH(QString, shape);
+
+    QVector<Sample> samples;
+    foreach (int snippets, sizes()) {
+        CorpusGenerator::Options options;
+        options.snippets = snippets;
+        options.bodyBytes = 256;
+        const int folders = qMax(1, snippets / SnippetsPerFolder);
+        if (shape == QLatin1String("wide-flat")) {
+            options.depth = 1;
+            options.fanout = folders;
+        } else if (shape == QLatin1String("deep-narrow")) {
+            // Bounded by PATH_MAX, ~7 characters per level
+            options.depth = qMin(folders, 400);
+            options.fanout = 1;
+        } else {
+            options.fanout = 4;
+            options.depth = qMax(1, int(std::ceil(std::log(double(folders)) / std::log(4.0))));
+        }
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        CorpusGenerator generator(options);
+        QVERIFY(generator.generate(dir.path()));
+        qputenv("SNIPPY_FOLDER", dir.path().toUtf8());
+
+        SnippetModel model;
+        SnippetProxyModel proxy;
+        proxy.setSourceModel(&model);
+
+        Sample sample;
+        sample.work = generator.totalDepth() + snippets;
+        sample.loadNs = std::numeric_limits<qint64>::max();
+        sample.filterNs = std::numeric_limits<qint64>::max();
+
+        // Best of a few, the minimum is what's least disturbed by the rest of the machine
+        for (int i = 0; i < LoadRepeats; ++i) {
+            QSignalSpy spy(&model, &SnippetModel::loaded);
+            QElapsedTimer timer;
+            timer.start();
+            model.load();
+            QVERIFY(spy.wait(LoadTimeoutMs));
+            sample.loadNs = qMin(sample.loadNs, timer.nsecsElapsed());
+        }
+
+        for (int i = 0; i < FilterRepeats; ++i) {
+            proxy.setFilterText(QString());
+            QElapsedTimer timer;
+            timer.start();
+            proxy.setFilterText(QStringLiteral("alpha"));
+            sample.filterNs = qMin(sample.filterNs, timer.nsecsElapsed());
+        }
+
+        qInfo().noquote() << QStringLiteral("%1 %2: work=%3 load=%4ms filter=%5ms")
+                                 .arg(shape)
+                                 .arg(options.toString())
+                                 .arg(sample.work)
+                                 .arg(sample.loadNs / 1e6, 0, 'f', 2)
+                                 .arg(sample.filterNs / 1e6, 0, 'f', 2);
+        samples << sample;
+    }
+
+    if (samples.size() < 2)
+        QSKIP("Needs at least two sizes to fit");
+
+    const double loadSlope = logLogSlope(samples, &Sample::loadNs);
+    const double filterSlope = logLogSlope(samples, &Sample::filterNs);
+    qInfo().noquote() << QStringLiteral("%1: load ~ work^%2, filter ~ work^%3").arg(shape).arg(loadSlope, 0, 'f', 2).arg(filterSlope, 0, 'f', 2);
+
+    QVERIFY2(loadSlope < MaxSlope, qPrintable(QStringLiteral("load grows as work^%1").arg(loadSlope, 0, 'f', 2)));
+    QVERIFY2(filterSlope < MaxSlope, qPrintable(QStringLiteral("filter grows as work^%1").arg(filterSlope, 0, 'f', 2)));
+}
+
+int main(int argc, char **argv)
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    ScalingTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "scalingtest.moc"
@@ -0,0 +1,225 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "corpussnapshot.h"
+#include "pathnode.h"
+#include "snippet.h"
+
+#include <QCoreApplication>
+#include <QSet>
+#include <QSignalSpy>
+#include <QThread>
+#include <QtTest>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// What readers outside the GUI thread get from CorpusPublisher
+
+class SnapshotTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void addAndRemove();
+    void sharedBlocks();
+    void renameFolder();
+    void concurrentReader();
+
+private:
+    static Snippet *makeSnippet(const PathNode *folder, const QString &fileName, const QString &title);
+    static std::shared_ptr<const CorpusSnapshot> publish(CorpusPublisher &);
+    static QSet<QString> titles(const CorpusSnapshot &);
+};
+
+Snippet *SnapshotTest::makeSnippet(const PathNode *folder, const QString &fileName, const QString &title)
+{
+    SnippetData data;
+    data.absolutePath = folder->absolutePath() + QLatin1Char('/') + fileName;
+    data.title = title;
+    data.tags = QStringList({ QStringLiteral("tag") });
+    data.contents = QStringLiteral("body");
+    return new Snippet(data, folder);
+}
+
+std::shared_ptr<const CorpusSnapshot> SnapshotTest::publish(CorpusPublisher &publisher)
+{
+    QSignalSpy spy(&publisher, &CorpusPublisher::published);
+    if (!spy.wait())
+        return nullptr;
+
+    return publisher.current();
+}
+
+QSet<QString> SnapshotTest::titles(const CorpusSnapshot &snapshot)
+{
+    QSet<QString> result;
+    for (int i = 0; i < snapshot.count(); ++i)
+        result.insert(snapshot.at(i).title);
+    return result;
+}
+
+void SnapshotTest::addAndRemove()
+{
+    PathNode root(QStringLiteral("/data"));
+    PathNode folder(QStringLiteral("docker"), &root);
+    std::unique_ptr<Snippet> a(makeSnippet(&folder, QStringLiteral("a.snip"), QStringLiteral("A")));
+    std::unique_ptr<Snippet> b(makeSnippet(&folder, QStringLiteral("b.snip"), QStringLiteral("B")));
+    std::unique_ptr<Snippet> c(makeSnippet(&root, QStringLiteral("c.snip"), QStringLiteral("C")));
+
+    CorpusPublisher publisher;
+    QCOMPARE(publisher.current()->count(), 0);
+    publisher.add(a.get());
+    publisher.add(b.get());
+    publisher.add(c.get());
+    publisher.add(a.get()); // Already in
+    const std::shared_ptr<const CorpusSnapshot> first = publish(publisher);
+    QVERIFY(first);
+    QCOMPARE(first->count(), 3);
+    QCOMPARE(first->at(0).title, QStringLiteral("A"));
+    QCOMPARE(first->absolutePath(first->at(0)), QStringLiteral("/data/docker/a.snip"));
+    QCOMPARE(first->relativePath(first->at(0)), QStringLiteral("/docker/a.snip"));
+    QCOMPARE(first->relativePath(first->at(2)), c->relativePath());
+    QCOMPARE(first->absolutePath(first->at(2)), c->absolutePath());
+
+    // The last entry takes the removed one's place
+    publisher.remove(a.get());
+    const std::shared_ptr<const CorpusSnapshot> second = publish(publisher);
+    QVERIFY(second);
+    QCOMPARE(second->version(), first->version() + 1);
+    QCOMPARE(second->count(), 2);
+    QCOMPARE(second->at(0).title, QStringLiteral("C"));
+    QCOMPARE(titles(*second), QSet<QString>({ QStringLiteral("B"), QStringLiteral("C") }));
+
+    // Removing the one that moved still finds it
+    publisher.remove(c.get());
+    publisher.remove(c.get());
+    const std::shared_ptr<const CorpusSnapshot> third = publish(publisher);
+    QVERIFY(third);
+    QCOMPARE(titles(*third), QSet<QString>({ QStringLiteral("B") }));
+
+    // Readers holding older snapshots don't see any of it
+    QCOMPARE(titles(*first), QSet<QString>({ QStringLiteral("A"), QStringLiteral("B"), QStringLiteral("C") }));
+    QCOMPARE(second->count(), 2);
+}
+
+void SnapshotTest::sharedBlocks()
+{
+    PathNode root(QStringLiteral("/data"));
+    std::vector<std::unique_ptr<Snippet>> snippets;
+    CorpusPublisher publisher;
+    for (int i = 0; i < 1500; ++i) { // Two blocks
+        snippets.emplace_back(makeSnippet(&root, QStringLiteral("%1.snip").arg(i), QString::number(i)));
+        publisher.add(snippets.back().get());
+    }
+
+    const std::shared_ptr<const CorpusSnapshot> first = publish(publisher);
+    QVERIFY(first);
+    publisher.remove(snippets.at(1200).get());
+    const std::shared_ptr<const CorpusSnapshot> second = publish(publisher);
+    QVERIFY(second);
+
+    // Only the block that changed was copied
+    QCOMPARE(&second->at(0), &first->at(0));
+    QVERIFY(&second->at(1100) != &first->at(1100));
+    QCOMPARE(first->at(1200).title, QStringLiteral("1200"));
+    QCOMPARE(second->at(1200).title, QStringLiteral("1499"));
+    QCOMPARE(second->count(), 1499);
+}
+
+void SnapshotTest::renameFolder()
+{
+    PathNode root(QStringLiteral("/data"));
+    PathNode folder(QStringLiteral("docker"), &root);
+    PathNode subFolder(QStringLiteral("compose"), &folder);
+    std::unique_ptr<Snippet> a(makeSnippet(&subFolder, QStringLiteral("a.snip"), QStringLiteral("A")));
+    std::unique_ptr<Snippet> b(makeSnippet(&root, QStringLiteral("b.snip"), QStringLiteral("B")));
+
+    CorpusPublisher publisher;
+    publisher.add(a.get());
+    publisher.add(b.get());
+    const std::shared_ptr<const CorpusSnapshot> before = publish(publisher);
+    QVERIFY(before);
+
+    folder.setName(QStringLiteral("containers"));
+    publisher.renameFolder(&folder);
+    const std::shared_ptr<const CorpusSnapshot> after = publish(publisher);
+    QVERIFY(after);
+
+    // One folder record changed, the entries below it are the same ones
+    QCOMPARE(&after->at(0), &before->at(0));
+    QCOMPARE(after->absolutePath(after->at(0)), QStringLiteral("/data/containers/compose/a.snip"));
+    QCOMPARE(after->relativePath(after->at(0)), a->relativePath());
+    QCOMPARE(after->absolutePath(after->at(1)), QStringLiteral("/data/b.snip"));
+    QCOMPARE(before->absolutePath(before->at(0)), QStringLiteral("/data/docker/compose/a.snip"));
+}
+
+void SnapshotTest::concurrentReader()
+{
+    PathNode root(QStringLiteral("/data"));
+    PathNode folder(QStringLiteral("folder"), &root);
+    std::vector<std::unique_ptr<Snippet>> snippets;
+    for (int i = 0; i < 3000; ++i)
+        snippets.emplace_back(makeSnippet(&folder, QStringLiteral("%1.snip").arg(i), QString::number(i)));
+
+    // Every snapshot a reader gets is whole: as many entries as it says, all of them complete
+    CorpusPublisher publisher;
+    std::atomic<bool> stop(false);
+    std::atomic<int> snapshotsRead(0);
+    std::atomic<int> broken(0);
+    QThread *reader = QThread::create([&] {
+        while (!stop) {
+            const std::shared_ptr<const CorpusSnapshot> snapshot = publisher.current();
+            for (int i = 0; i < snapshot->count(); ++i) {
+                const SnapshotEntry &entry = snapshot->at(i);
+                if (entry.title.isEmpty() || !snapshot->relativePath(entry).startsWith(QLatin1String("/folder/")))
+                    ++broken;
+            }
+            ++snapshotsRead;
+        }
+    });
+    reader->start();
+
+    for (int round = 0; round < 5; ++round) {
+        for (const auto &snippet : snippets)
+            publisher.add(snippet.get());
+        QVERIFY(publish(publisher));
+        for (int i = round; i < int(snippets.size()); i += 3)
+            publisher.remove(snippets.at(i).get());
+        QVERIFY(publish(publisher));
+    }
+
+    stop = true;
+    reader->wait();
+    delete reader;
+    QVERIFY(snapshotsRead > 0);
+    QCOMPARE(broken.load(), 0);
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    SnapshotTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "snapshottest.moc"
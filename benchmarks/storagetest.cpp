@@ -0,0 +1,295 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "bodystore.h"
+#include "directorystorage.h"
+#include "packedstorage.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtTest>
+
+// Round-trips the on-disk formats through what a crash leaves behind, and bodies through
+// BodyStore's compression
+
+class StorageTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void packTornRecord();
+    void packCompactedElsewhere();
+    void journalReplay();
+    void journalSecondProcess();
+    void compressedChunks();
+    void bodyStoreSurrogates();
+
+private:
+    static QByteArray readFile(const QString &path);
+    static void writeFile(const QString &path, const QByteArray &bytes);
+    static bool readSnippet(SnippetStorage &, const QString &absolutePath, SnippetData &data);
+};
+
+QByteArray StorageTest::readFile(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+void StorageTest::writeFile(const QString &path, const QByteArray &bytes)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(bytes), qint64(bytes.size()));
+}
+
+bool StorageTest::readSnippet(SnippetStorage &storage, const QString &absolutePath, SnippetData &data)
+{
+    data = SnippetData();
+    return storage.read(absolutePath, data);
+}
+
+void StorageTest::packTornRecord()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString packPath = dir.filePath(QStringLiteral("test.snippack"));
+    const QString first = packPath + QStringLiteral("/folder/first.snip");
+    const QString second = packPath + QStringLiteral("/folder/second.snip");
+    const QString third = packPath + QStringLiteral("/third.snip");
+
+    {
+        PackedStorage storage(packPath);
+        QVERIFY(storage.write(first, QStringLiteral("First"), { QStringLiteral("a"), QStringLiteral("b") }, QStringLiteral("one")));
+        QVERIFY(storage.write(second, QStringLiteral("Second"), {}, QStringLiteral("two")));
+    }
+
+    // A crash in the middle of appending the second record
+    QFile file(packPath);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() - 2));
+    file.close();
+
+    {
+        PackedStorage storage(packPath);
+        SnippetData data;
+        QVERIFY(readSnippet(storage, first, data));
+        QCOMPARE(data.title, QStringLiteral("First"));
+        QCOMPARE(data.tags, QStringList({ QStringLiteral("a"), QStringLiteral("b") }));
+        QCOMPARE(data.contents, QStringLiteral("one"));
+        QVERIFY(!storage.exists(second));
+
+        // Appended where the torn record started, not after it
+        QVERIFY(storage.write(third, QStringLiteral("Third"), {}, QStringLiteral("three")));
+    }
+
+    PackedStorage storage(packPath);
+    SnippetData data;
+    QVERIFY(readSnippet(storage, first, data));
+    QCOMPARE(data.contents, QStringLiteral("one"));
+    QVERIFY(readSnippet(storage, third, data));
+    QCOMPARE(data.title, QStringLiteral("Third"));
+    QCOMPARE(data.contents, QStringLiteral("three"));
+    QVERIFY(!storage.exists(second));
+}
+
+void StorageTest::packCompactedElsewhere()
+{
+#ifndef Q_OS_UNIX
+    QSKIP("A pack that's open elsewhere can't be replaced on this platform");
+#endif
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString packPath = dir.filePath(QStringLiteral("test.snippack"));
+    const QString first = packPath + QStringLiteral("/first.snip");
+    const QString second = packPath + QStringLiteral("/second.snip");
+
+    // b opens the pack while a holds the lock, c gets the lock once a is gone and compacts
+    auto a = new PackedStorage(packPath);
+    QVERIFY(a->write(first, QStringLiteral("First"), {}, QStringLiteral("one")));
+    PackedStorage b(packPath);
+    delete a;
+    {
+        PackedStorage c(packPath);
+        QVERIFY(c.write(first, QStringLiteral("First"), {}, QStringLiteral("one, again"))); // Some garbage
+        QVERIFY(c.compact());
+
+        QVERIFY(b.write(second, QStringLiteral("Second"), {}, QStringLiteral("two")));
+    }
+
+    PackedStorage storage(packPath);
+    SnippetData data;
+    QVERIFY(readSnippet(storage, first, data));
+    QCOMPARE(data.contents, QStringLiteral("one, again"));
+    QVERIFY(readSnippet(storage, second, data));
+    QCOMPARE(data.title, QStringLiteral("Second"));
+    QCOMPARE(data.contents, QStringLiteral("two"));
+}
+
+void StorageTest::journalReplay()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("snippet.snip"));
+    const QString journalPath = dir.filePath(QStringLiteral(".snippy-journal"));
+    const QString body = QStringLiteral("line\n").repeated(100);
+    const QString editedBody = QStringLiteral("first\n") + body.mid(5, 200) + QStringLiteral("edited\n") + body.mid(300);
+
+    QByteArray journal;
+    QByteArray original;
+    {
+        DirectoryStorage storage(dir.path());
+        QVERIFY(storage.write(path, QStringLiteral("Title"), { QStringLiteral("tag") }, body)); // The file itself
+        QVERIFY(storage.write(path, QStringLiteral("Title"), { QStringLiteral("tag") }, body + QStringLiteral("more"))); // A full record
+        QVERIFY(storage.write(path, QStringLiteral("Edited"), { QStringLiteral("b"), QStringLiteral("a") }, editedBody)); // A delta
+        journal = readFile(journalPath);
+        original = readFile(path);
+    }
+
+    // As if the process died before folding, in the middle of appending another record
+    writeFile(path, original);
+    writeFile(journalPath, journal + QByteArray("\x40\0\0\0\x12\x34", 6));
+
+    {
+        DirectoryStorage storage(dir.path()); // Replays and folds
+        SnippetData data;
+        QVERIFY(readSnippet(storage, path, data));
+        QCOMPARE(data.title, QStringLiteral("Edited"));
+        QCOMPARE(data.tags, QStringList({ QStringLiteral("b"), QStringLiteral("a") }));
+        QCOMPARE(data.contents, editedBody);
+
+        QVERIFY(storage.write(path, QStringLiteral("Again"), {}, editedBody));
+        journal = readFile(journalPath);
+        original = readFile(path);
+    }
+
+    // Dying again, what was journaled after the torn tail must replay too
+    writeFile(path, original);
+    writeFile(journalPath, journal);
+
+    DirectoryStorage storage(dir.path());
+    SnippetData data;
+    QVERIFY(readSnippet(storage, path, data));
+    QCOMPARE(data.title, QStringLiteral("Again"));
+    QCOMPARE(data.contents, editedBody);
+}
+
+void StorageTest::journalSecondProcess()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("snippet.snip"));
+
+    DirectoryStorage first(dir.path());
+    QVERIFY(first.write(path, QStringLiteral("Title"), {}, QStringLiteral("body"))); // The file itself
+    QVERIFY(first.write(path, QStringLiteral("First"), {}, QStringLiteral("journaled")));
+    QVERIFY(QFileInfo(dir.filePath(QStringLiteral(".snippy-journal"))).size() > 0);
+    QTest::qSleep(50); // File times can be coarser than the clock
+
+    // Can't take the journal's lock, so it writes the file like before journaling
+    DirectoryStorage second(dir.path());
+    QVERIFY(second.write(path, QStringLiteral("Second"), {}, QStringLiteral("changed")));
+
+    SnippetData data;
+    SnippetStorage::parse(readFile(path), data, /*headerOnly=*/false);
+    QCOMPARE(data.title, QStringLiteral("Second"));
+    QCOMPARE(data.contents, QStringLiteral("changed"));
+
+    // Folding first's older edit must not bring it back
+    first.flush();
+    SnippetStorage::parse(readFile(path), data, /*headerOnly=*/false);
+    QCOMPARE(data.title, QStringLiteral("Second"));
+    QCOMPARE(data.contents, QStringLiteral("changed"));
+
+    // An edit after that wins in turn
+    QTest::qSleep(50);
+    QVERIFY(first.write(path, QStringLiteral("Third"), {}, QStringLiteral("last")));
+    first.flush();
+    SnippetStorage::parse(readFile(path), data, /*headerOnly=*/false);
+    QCOMPARE(data.title, QStringLiteral("Third"));
+    QCOMPARE(data.contents, QStringLiteral("last"));
+}
+
+void StorageTest::compressedChunks()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("large.snip"));
+
+    // The first chunk ends at the last line break before 64 KB. The long line has none, so
+    // the second chunk is cut 65536 bytes into it, which is inside the needle.
+    QString body;
+    for (int i = 0; body.size() < 60 * 1024; ++i)
+        body += QStringLiteral("line %1\n").arg(i);
+    body += QString(32766, QChar(0xE9)) + QStringLiteral("NEEDLE") + QString(1000, QChar(0xE9)) + QStringLiteral("\nlast\n");
+
+    DirectoryStorage storage(dir.path());
+    QVERIFY(storage.write(path, QStringLiteral("Large"), { QStringLiteral("big") }, body));
+    QVERIFY(readFile(path).contains(QByteArray("\0snipz1\n", 8)));
+    QVERIFY(readFile(path).size() < body.toUtf8().size());
+
+    SnippetData data;
+    QVERIFY(readSnippet(storage, path, data));
+    QCOMPARE(data.title, QStringLiteral("Large"));
+    QCOMPARE(data.contents, body);
+    QVERIFY(storage.contains(path, QStringLiteral("needle")));
+    QVERIFY(storage.contains(path, QStringLiteral("last")));
+    QVERIFY(!storage.contains(path, QStringLiteral("missing")));
+
+    // What the external editor gets
+    QVERIFY(storage.makeEditable(path));
+    SnippetStorage::parse(readFile(path), data, /*headerOnly=*/false);
+    QCOMPARE(data.contents, body);
+}
+
+void StorageTest::bodyStoreSurrogates()
+{
+    // An emoji across BodyStore's 32K QChar chunk boundary
+    const QString emoji = QString::fromUtf8("\xF0\x9F\x98\x80");
+    const QString body = QString(32 * 1024 - 1, QLatin1Char('a')) + emoji + QStringLiteral("tail");
+
+    BodyStore &store = BodyStore::instance();
+    const qint64 budget = store.budget();
+    const int id = store.add();
+    store.setBody(id, body, /*dirty=*/true); // Compressed rather than dropped
+    store.setBudget(0);
+    QCOMPARE(store.stats().compressed, 1);
+
+    QCOMPARE(store.find(id, emoji, Qt::CaseSensitive), BodyStore::Found);
+    QString contents;
+    QVERIFY(store.body(id, contents));
+    QCOMPARE(contents, body);
+
+    store.remove(id);
+    store.setBudget(budget);
+}
+
+int main(int argc, char **argv)
+{
+    qputenv("SNIPPY_COMPRESS_KB", "64"); // The default, whatever the environment says
+    QCoreApplication app(argc, argv);
+    StorageTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "storagetest.moc"
@@ -0,0 +1,297 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "bodystore.h"
+#include "filterquery.h"
+
+enum {
+    DefaultBudgetMB = 256,
+    ChunkChars = 32 * 1024,
+    MinCompressedChars = 1024 // Below this qCompress' overhead eats most of the gain
+};
+
+BodyStore &BodyStore::instance()
+{
+    static BodyStore store;
+    return store;
+}
+
+BodyStore::BodyStore()
+{
+    bool ok = false;
+    const int mb = qEnvironmentVariableIntValue("SNIPPY_BODY_CACHE_MB", &ok);
+    m_budget = qint64(ok && mb > 0 ? mb : DefaultBudgetMB) * 1024 * 1024;
+}
+
+int BodyStore::allocate()
+{
+    if (!m_freeIds.isEmpty())
+        return m_freeIds.takeLast();
+
+    m_entries.append(Entry());
+    return m_entries.size() - 1;
+}
+
+int BodyStore::add()
+{
+    return allocate();
+}
+
+int BodyStore::add(const QString &body)
+{
+    const int id = allocate();
+    storeDecoded(id, body);
+    enforceBudget(id);
+    return id;
+}
+
+void BodyStore::remove(int id)
+{
+    drop(id);
+    m_entries[id].dirty = false;
+    m_freeIds.append(id);
+}
+
+bool BodyStore::body(int id, QString &body)
+{
+    Entry &entry = m_entries[id];
+    switch (entry.state) {
+    case NotResidentState:
+        return false;
+    case DecodedState:
+        unlink(m_decoded, id);
+        link(m_decoded, id);
+        body = entry.decoded;
+        return true;
+    case CompressedState:
+        body = decompress(entry);
+        storeDecoded(id, body);
+        enforceBudget(id);
+        return true;
+    }
+
+    return false;
+}
+
+void BodyStore::setBody(int id, const QString &body, bool dirty)
+{
+    storeDecoded(id, body);
+    m_entries[id].dirty = dirty;
+    enforceBudget(id);
+}
+
+void BodyStore::setClean(int id)
+{
+    m_entries[id].dirty = false;
+}
+
+BodyStore::Lookup BodyStore::find(int id, const QString &text, Qt::CaseSensitivity cs) const
+{
+    const Entry &entry = m_entries.at(id);
+    switch (entry.state) {
+    case NotResidentState:
+        return NotResident;
+    case DecodedState:
+        return entry.decoded.contains(text, cs) ? Found : NotFound;
+    case CompressedState: {
+        // One chunk at a time, keeping the previous chunk's tail for matches across the boundary
+        QString window;
+        foreach (const QByteArray &chunk, entry.chunks) {
+            window += QString::fromUtf8(qUncompress(chunk));
+            if (window.contains(text, cs))
+                return Found;
+            window = window.right(text.size() - 1);
+        }
+        return NotFound;
+    }
+    }
+
+    return NotFound;
+}
+
+BodyStore::Lookup BodyStore::find(int id, const QRegularExpression &pattern) const
+{
+    const Entry &entry = m_entries.at(id);
+    switch (entry.state) {
+    case NotResidentState:
+        return NotResident;
+    case DecodedState:
+        return FilterQuery::matchPattern(pattern, entry.decoded) ? Found : NotFound;
+    case CompressedState:
+        return FilterQuery::matchPattern(pattern, decompress(entry)) ? Found : NotFound;
+    }
+
+    return NotFound;
+}
+
+qint64 BodyStore::budget() const
+{
+    return m_budget;
+}
+
+void BodyStore::setBudget(qint64 bytes)
+{
+    m_budget = bytes;
+    enforceBudget();
+}
+
+qint64 BodyStore::residentBytes() const
+{
+    return m_decodedBytes + m_compressedBytes;
+}
+
+BodyStore::Stats BodyStore::stats() const
+{
+    Stats stats;
+    stats.decodedBytes = m_decodedBytes;
+    stats.compressedBytes = m_compressedBytes;
+    for (int id = 0, count = m_entries.size(); id < count; ++id) {
+        switch (m_entries.at(id).state) {
+        case NotResidentState:
+            stats.notResident++;
+            break;
+        case DecodedState:
+            stats.decoded++;
+            break;
+        case CompressedState:
+            stats.compressed++;
+            break;
+        }
+    }
+
+    stats.notResident -= m_freeIds.size();
+    return stats;
+}
+
+void BodyStore::link(List &list, int id)
+{
+    Entry &entry = m_entries[id];
+    entry.prev = -1;
+    entry.next = list.head;
+    if (list.head != -1)
+        m_entries[list.head].prev = id;
+    list.head = id;
+    if (list.tail == -1)
+        list.tail = id;
+}
+
+void BodyStore::unlink(List &list, int id)
+{
+    Entry &entry = m_entries[id];
+    if (entry.prev != -1)
+        m_entries[entry.prev].next = entry.next;
+    else
+        list.head = entry.next;
+
+    if (entry.next != -1)
+        m_entries[entry.next].prev = entry.prev;
+    else
+        list.tail = entry.prev;
+
+    entry.prev = -1;
+    entry.next = -1;
+}
+
+void BodyStore::drop(int id)
+{
+    Entry &entry = m_entries[id];
+    if (entry.state == DecodedState) {
+        unlink(m_decoded, id);
+        m_decodedBytes -= entry.bytes;
+    } else if (entry.state == CompressedState) {
+        unlink(m_compressed, id);
+        m_compressedBytes -= entry.bytes;
+    }
+
+    entry.state = NotResidentState;
+    entry.decoded.clear();
+    entry.chunks.clear();
+    entry.bytes = 0;
+}
+
+void BodyStore::storeDecoded(int id, const QString &body)
+{
+    drop(id);
+    Entry &entry = m_entries[id];
+    entry.state = DecodedState;
+    entry.decoded = body;
+    entry.bytes = body.size() * qint64(sizeof(QChar));
+    m_decodedBytes += entry.bytes;
+    link(m_decoded, id);
+}
+
+void BodyStore::compress(int id)
+{
+    const QString body = m_entries.at(id).decoded;
+    drop(id);
+
+    Entry &entry = m_entries[id];
+    int pos = 0;
+    while (pos < body.size()) {
+        // Chunks are decoded on their own, a surrogate pair mustn't be split between two
+        int length = qMin(int(ChunkChars), int(body.size()) - pos);
+        if (pos + length < body.size() && body.at(pos + length - 1).isHighSurrogate())
+            length--;
+        entry.chunks.append(qCompress(body.mid(pos, length).toUtf8()));
+        entry.bytes += entry.chunks.last().size();
+        pos += length;
+    }
+
+    entry.state = CompressedState;
+    m_compressedBytes += entry.bytes;
+    link(m_compressed, id);
+}
+
+/*static*/
+QString BodyStore::decompress(const Entry &entry)
+{
+    QString body;
+    foreach (const QByteArray &chunk, entry.chunks)
+        body += QString::fromUtf8(qUncompress(chunk));
+
+    return body;
+}
+
+void BodyStore::enforceBudget(int keep)
+{
+    // Coldest decoded bodies first, keep is the one the caller is about to use
+    int id = m_decoded.tail;
+    while (id != -1 && residentBytes() > m_budget) {
+        const int hotter = m_entries.at(id).prev;
+        if (id != keep) {
+            const Entry &entry = m_entries.at(id);
+            if (entry.decoded.size() >= MinCompressedChars)
+                compress(id);
+            else if (!entry.dirty)
+                drop(id);
+        }
+        id = hotter;
+    }
+
+    id = m_compressed.tail;
+    while (id != -1 && residentBytes() > m_budget) {
+        const int hotter = m_entries.at(id).prev;
+        if (!m_entries.at(id).dirty)
+            drop(id);
+        id = hotter;
+    }
+}
@@ -0,0 +1,119 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_BODY_STORE_H
+#define SNIPPY_BODY_STORE_H
+
+#include <QByteArray>
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+
+// Holds snippet bodies within a memory budget (SNIPPY_BODY_CACHE_MB, 256 by default).
+// Recently used bodies stay decoded. When over budget the coldest ones are compressed,
+// in independent chunks so they can be searched without decoding them whole, and after
+// that the coldest compressed ones are dropped, to be re-read from disk on demand.
+// Small bodies aren't worth compressing and are dropped directly.
+// Bodies with unsaved edits are never dropped. GUI thread only.
+
+class BodyStore
+{
+public:
+    enum Lookup {
+        NotFound = 0,
+        Found,
+        NotResident // Needs to be searched on disk
+    };
+
+    struct Stats
+    {
+        int decoded = 0;
+        int compressed = 0;
+        int notResident = 0;
+        qint64 decodedBytes = 0;
+        qint64 compressedBytes = 0;
+    };
+
+    static BodyStore &instance();
+
+    int add(); // Not resident yet
+    int add(const QString &body);
+    void remove(int id);
+
+    // Returns false if the body isn't resident anymore and needs to be re-read
+    bool body(int id, QString &body);
+    void setBody(int id, const QString &body, bool dirty = false);
+    void setClean(int id); // Saved, can be dropped if needed
+
+    // Searches the body without decoding all of it at once and without making it hot
+    Lookup find(int id, const QString &text, Qt::CaseSensitivity) const;
+    Lookup find(int id, const QRegularExpression &) const; // Decodes it whole, matches can span chunks
+
+    qint64 budget() const;
+    void setBudget(qint64 bytes);
+    qint64 residentBytes() const;
+    Stats stats() const;
+
+private:
+    enum State {
+        NotResidentState = 0,
+        DecodedState,
+        CompressedState
+    };
+
+    struct Entry
+    {
+        State state = NotResidentState;
+        bool dirty = false;
+        QString decoded;
+        QVector<QByteArray> chunks; // qCompress'ed UTF-8
+        qint64 bytes = 0; // What this entry costs towards the budget
+        int prev = -1; // Within the LRU list of its state, towards the hottest
+        int next = -1;
+    };
+
+    struct List
+    {
+        int head = -1; // Hottest
+        int tail = -1; // Coldest
+    };
+
+    BodyStore();
+    int allocate();
+    void link(List &, int id);
+    void unlink(List &, int id);
+    void drop(int id);
+    void storeDecoded(int id, const QString &body);
+    void compress(int id);
+    static QString decompress(const Entry &);
+    void enforceBudget(int keep = -1);
+
+    QVector<Entry> m_entries;
+    QVector<int> m_freeIds;
+    List m_decoded;
+    List m_compressed;
+    qint64 m_decodedBytes = 0;
+    qint64 m_compressedBytes = 0;
+    qint64 m_budget = 0;
+};
+
+#endif
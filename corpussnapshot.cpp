@@ -0,0 +1,238 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "corpussnapshot.h"
+#include "pathnode.h"
+#include "snippet.h"
+#include "snippetstorage.h"
+#include "tracer.h"
+
+enum {
+    BlockSize = 1024,
+    PublishIntervalMs = 50 // Coalesces a batch, like the scanner's chunks during a load
+};
+
+CorpusSnapshot::CorpusSnapshot(quint64 version, const Blocks &blocks, int count, const Folders &folders)
+    : m_version(version)
+    , m_blocks(blocks)
+    , m_count(count)
+    , m_folders(folders)
+{
+}
+
+quint64 CorpusSnapshot::version() const
+{
+    return m_version;
+}
+
+int CorpusSnapshot::count() const
+{
+    return m_count;
+}
+
+const SnapshotEntry &CorpusSnapshot::at(int i) const
+{
+    return m_blocks.at(i / BlockSize).at(i % BlockSize);
+}
+
+QString CorpusSnapshot::absolutePath(const SnapshotEntry &entry) const
+{
+    return folderPath(entry.folder, /*absolute=*/true) + QLatin1Char('/') + entry.fileName;
+}
+
+QString CorpusSnapshot::relativePath(const SnapshotEntry &entry) const
+{
+    return folderPath(entry.folder, /*absolute=*/false) + QLatin1Char('/') + entry.fileName;
+}
+
+QString CorpusSnapshot::folderPath(int folder, bool absolute) const
+{
+    // Like PathNode, a root's relative path is empty
+    QString path;
+    for (; folder != -1; folder = m_folders.at(folder).parent) {
+        const SnapshotFolder &node = m_folders.at(folder);
+        if (node.parent != -1)
+            path.prepend(QLatin1Char('/') + node.name);
+        else if (absolute)
+            path.prepend(node.name);
+    }
+
+    return path;
+}
+
+bool CorpusSnapshot::readBody(const SnapshotEntry &entry, QString &body) const
+{
+    const QString path = absolutePath(entry);
+    SnippetData data;
+    if (!SnippetStorage::forPath(path)->read(path, data))
+        return false;
+
+    body = data.contents;
+    return true;
+}
+
+MemoryUsage CorpusSnapshot::memoryUsage() const
+{
+    // Strings are shared with the snippets, only the tag lists are the snapshot's own
+    MemoryUsage usage;
+    usage.objects = m_count;
+    usage.bytes = qint64(m_blocks.size()) * BlockSize * qint64(sizeof(SnapshotEntry))
+        + m_folders.capacity() * qint64(sizeof(SnapshotFolder));
+    for (int i = 0; i < m_count; ++i)
+        usage.bytes += at(i).tags.size() * qint64(sizeof(void *));
+
+    return usage;
+}
+
+CorpusPublisher::CorpusPublisher(QObject *parent)
+    : QObject(parent)
+    , m_current(std::make_shared<const CorpusSnapshot>(0, CorpusSnapshot::Blocks(), 0, CorpusSnapshot::Folders()))
+{
+    m_publishTimer.setSingleShot(true);
+    m_publishTimer.setInterval(PublishIntervalMs);
+    connect(&m_publishTimer, &QTimer::timeout, this, &CorpusPublisher::publish);
+}
+
+std::shared_ptr<const CorpusSnapshot> CorpusPublisher::current() const
+{
+    return std::atomic_load(&m_current);
+}
+
+void CorpusPublisher::add(const Snippet *snippet)
+{
+    if (m_positions.contains(snippet))
+        return;
+
+    if (m_count % BlockSize == 0) {
+        m_blocks.append(QVector<SnapshotEntry>());
+        m_blocks.last().reserve(BlockSize);
+    }
+
+    m_blocks.last().append(makeEntry(snippet));
+    m_positions.insert(snippet, m_count);
+    m_snippets.append(snippet);
+    ++m_count;
+    schedulePublish();
+}
+
+void CorpusPublisher::update(const Snippet *snippet)
+{
+    const int position = m_positions.value(snippet, -1);
+    if (position == -1)
+        return;
+
+    entry(position) = makeEntry(snippet);
+    schedulePublish();
+}
+
+void CorpusPublisher::remove(const Snippet *snippet)
+{
+    const int position = m_positions.value(snippet, -1);
+    if (position == -1)
+        return;
+
+    // The last one takes its place
+    const int last = m_count - 1;
+    if (position != last) {
+        entry(position) = entry(last);
+        m_snippets[position] = m_snippets.at(last);
+        m_positions[m_snippets.at(position)] = position;
+    }
+
+    m_blocks.last().removeLast();
+    if (m_blocks.last().isEmpty())
+        m_blocks.removeLast();
+
+    m_snippets.removeLast();
+    m_positions.remove(snippet);
+    --m_count;
+    schedulePublish();
+}
+
+void CorpusPublisher::renameFolder(const PathNode *node)
+{
+    const int id = m_folderIds.value(node, -1);
+    if (id == -1)
+        return; // No snippet below it was added yet
+
+    m_folders[id].name = node->name();
+    schedulePublish();
+}
+
+void CorpusPublisher::clear()
+{
+    m_blocks.clear();
+    m_folders.clear();
+    m_folderIds.clear();
+    m_positions.clear();
+    m_snippets.clear();
+    m_count = 0;
+    schedulePublish();
+}
+
+void CorpusPublisher::publish()
+{
+    SNIPPY_TRACE("CorpusPublisher::publish");
+
+    // The outer vector is copied, the blocks are shared until the next mutation touches them
+    std::shared_ptr<const CorpusSnapshot> snapshot = std::make_shared<const CorpusSnapshot>(++m_version, m_blocks, m_count, m_folders);
+    std::atomic_store(&m_current, snapshot);
+    emit published(m_version);
+}
+
+void CorpusPublisher::schedulePublish()
+{
+    if (!m_publishTimer.isActive())
+        m_publishTimer.start();
+}
+
+SnapshotEntry &CorpusPublisher::entry(int position)
+{
+    return m_blocks[position / BlockSize][position % BlockSize];
+}
+
+SnapshotEntry CorpusPublisher::makeEntry(const Snippet *snippet)
+{
+    SnapshotEntry entry;
+    entry.folder = folderId(snippet->folder());
+    entry.fileName = snippet->fileName();
+    entry.title = snippet->title();
+    entry.tags = snippet->tags();
+    return entry;
+}
+
+int CorpusPublisher::folderId(const PathNode *node)
+{
+    if (!node)
+        return -1;
+
+    auto it = m_folderIds.constFind(node);
+    if (it != m_folderIds.cend())
+        return *it;
+
+    SnapshotFolder folder;
+    folder.parent = folderId(node->parent());
+    folder.name = node->name();
+    m_folders.append(folder);
+    m_folderIds.insert(node, m_folders.size() - 1);
+    return m_folders.size() - 1;
+}
@@ -0,0 +1,129 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_CORPUS_SNAPSHOT_H
+#define SNIPPY_CORPUS_SNAPSHOT_H
+
+#include "memorystats.h"
+
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+#include <memory>
+
+class PathNode;
+class Snippet;
+
+// A folder, linked to its parent like PathNode, so renaming one touches a single record
+struct SnapshotFolder
+{
+    int parent = -1; // Into the snapshot's folders, -1 for a root
+    QString name; // A root's is its absolute path
+};
+
+// One snippet, as it was when the snapshot was published
+struct SnapshotEntry
+{
+    int folder = -1;
+    QString fileName;
+    QString title;
+    QStringList tags;
+};
+
+// Immutable view of the whole corpus, for work outside the GUI thread.
+// Entries are in no particular order. Held by shared_ptr, it stays valid for as long
+// as a reader needs it, no matter what the GUI thread does meanwhile.
+class CorpusSnapshot
+{
+public:
+    typedef QVector<QVector<SnapshotEntry>> Blocks;
+    typedef QVector<SnapshotFolder> Folders;
+
+    CorpusSnapshot(quint64 version, const Blocks &blocks, int count, const Folders &folders);
+
+    quint64 version() const;
+    int count() const;
+    const SnapshotEntry &at(int i) const;
+
+    // Built from the folders, like the PathNodes do
+    QString absolutePath(const SnapshotEntry &) const; // Also the body handle, see readBody()
+    QString relativePath(const SnapshotEntry &) const;
+
+    // Thread-safe, through SnippetStorage. Unsaved edits aren't seen, like any other reader of the files.
+    bool readBody(const SnapshotEntry &, QString &body) const;
+
+    MemoryUsage memoryUsage() const;
+
+private:
+    QString folderPath(int folder, bool absolute) const;
+
+    const quint64 m_version;
+    const Blocks m_blocks;
+    const int m_count;
+    const Folders m_folders;
+};
+
+// Keeps the snapshot in sync with the model and publishes a new one, RCU-style, after each
+// batch of mutations. Entries live in fixed-size implicitly shared blocks, so publishing copies
+// one pointer per block and the next mutation only detaches the block it touches. Folders are
+// one implicitly shared vector, there are far fewer of them.
+// GUI thread only, except for current().
+class CorpusPublisher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CorpusPublisher(QObject *parent = nullptr);
+
+    // Thread-safe, never null
+    std::shared_ptr<const CorpusSnapshot> current() const;
+
+    void add(const Snippet *);
+    void update(const Snippet *);
+    void remove(const Snippet *);
+    void renameFolder(const PathNode *); // After PathNode::setName(), the snippets below follow
+    void clear();
+
+Q_SIGNALS:
+    void published(quint64 version);
+
+private:
+    void publish();
+    void schedulePublish();
+    SnapshotEntry &entry(int position);
+    SnapshotEntry makeEntry(const Snippet *);
+    int folderId(const PathNode *); // Adds it and its ancestors if they're new
+
+    CorpusSnapshot::Blocks m_blocks;
+    CorpusSnapshot::Folders m_folders; // Never shrink until clear(), nodes live as long
+    QHash<const PathNode *, int> m_folderIds;
+    int m_count = 0;
+    quint64 m_version = 0;
+    QHash<const Snippet *, int> m_positions;
+    QVector<const Snippet *> m_snippets; // By position, to fix up m_positions when the last one moves
+    QTimer m_publishTimer;
+    std::shared_ptr<const CorpusSnapshot> m_current;
+};
+
+#endif
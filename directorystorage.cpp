@@ -0,0 +1,328 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "directorystorage.h"
+#include "journal.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <functional>
+#include <limits>
+
+// Large bodies are stored compressed, after the usual title and tags lines and a marker line.
+// The body is a series of independently compressed chunks, each prefixed by its size, so it
+// can be decompressed and searched a chunk at a time. Chunks end at line breaks if possible.
+static const char s_compressedMarker[] = "\0snipz1\n"; // Can't start a text body
+
+enum {
+    TitleLine = 0,
+    TagsLine = 1,
+    BodyLine = 2,
+    MarkerSize = sizeof(s_compressedMarker) - 1,
+    ChunkBytes = 64 * 1024,
+    DefaultCompressKb = 64
+};
+
+static QByteArray compressedMarker()
+{
+    return QByteArray(s_compressedMarker, MarkerSize);
+}
+
+// SNIPPY_COMPRESS_KB, bodies at least this large are compressed on save. 0 disables it.
+static qint64 compressionThreshold()
+{
+    static const qint64 threshold = [] {
+        bool ok = false;
+        const int kb = qEnvironmentVariableIntValue("SNIPPY_COMPRESS_KB", &ok);
+        if (!ok)
+            return qint64(DefaultCompressKb) * 1024;
+        return kb > 0 ? qint64(kb) * 1024 : std::numeric_limits<qint64>::max();
+    }();
+
+    return threshold;
+}
+
+// Feeds the decompressed chunks to callback until it returns false. Returns false if corrupt.
+static bool forEachChunk(QIODevice &file, const std::function<bool(const QByteArray &)> &callback)
+{
+    while (!file.atEnd()) {
+        const QByteArray size = file.read(4);
+        if (size.size() != 4)
+            return false;
+
+        const QByteArray chunk = qUncompress(file.read(qFromBigEndian<quint32>(size.constData())));
+        if (chunk.isEmpty())
+            return false;
+
+        if (!callback(chunk))
+            break;
+    }
+
+    return true;
+}
+
+DirectoryStorage::DirectoryStorage(const QString &root)
+    : SnippetStorage(root)
+{
+    if (root.isEmpty())
+        return;
+
+    // Each process keeps its own pending states, two of them would interleave their records
+    // and rotate each other's generations. --new-instance and --export both open a root again.
+    m_journalLock.reset(new QLockFile(root + QStringLiteral("/.snippy-journal.lock")));
+    m_journalLock->setStaleLockTime(0); // Only stale if the holder died
+    if (m_journalLock->tryLock(0))
+        m_journal.reset(new Journal(root));
+    else
+        qWarning() << Q_FUNC_INFO << root << "is journaled by another process, saving files directly";
+}
+
+DirectoryStorage::~DirectoryStorage()
+{
+}
+
+bool DirectoryStorage::list(const QString &folderPath, QStringList &snippetNames, QStringList &subFolders)
+{
+    QDir dir(folderPath);
+    if (!dir.exists())
+        return false;
+
+    dir.setNameFilters({ "*.snip" });
+    dir.setFilter(QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+    snippetNames = dir.entryList();
+
+    dir.setNameFilters({});
+    dir.setFilter(QDir::AllDirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+    subFolders = dir.entryList();
+    return true;
+}
+
+bool DirectoryStorage::read(const QString &absolutePath, SnippetData &data, bool headerOnly)
+{
+    if (m_journal && m_journal->pending(absolutePath, data, headerOnly)) {
+        // The file is older than the edit, but close enough for sorting
+        const QFileInfo info(absolutePath);
+        data.size = info.size();
+        data.modified = info.exists() ? info.lastModified().toMSecsSinceEpoch() : QDateTime::currentMSecsSinceEpoch();
+        return true;
+    }
+
+    data.absolutePath = absolutePath;
+
+    QFile file(absolutePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << Q_FUNC_INFO << "Failed to open " << absolutePath << " due to " << file.errorString();
+        return false;
+    }
+
+    data.size = file.size();
+    data.modified = file.fileTime(QFileDevice::FileModificationTime).toMSecsSinceEpoch();
+
+    // Line by line, so a header-only read stops early
+    int i = 0;
+    while (!file.atEnd()) {
+        const QByteArray bytes = file.readLine();
+        if (i == BodyLine && bytes == compressedMarker()) {
+            file.setTextModeEnabled(false);
+            const bool ok = forEachChunk(file, [&data](const QByteArray &chunk) {
+                data.contents += QString::fromUtf8(chunk);
+                return true;
+            });
+            if (!ok)
+                qWarning() << Q_FUNC_INFO << "Corrupt compressed body in" << absolutePath;
+            break;
+        }
+
+        const QString line = QString::fromUtf8(bytes);
+        if (i == TitleLine) {
+            data.title = line.trimmed();
+        } else if (i == TagsLine) {
+            data.tags = line.trimmed().split(";");
+            if (headerOnly) {
+                data.hasContents = false;
+                break;
+            }
+        } else {
+            data.contents += line;
+        }
+
+        ++i;
+    }
+
+    if (data.title.isEmpty()) {
+        qWarning() << Q_FUNC_INFO << "Invalid snippet" << absolutePath;
+    }
+
+    return true;
+}
+
+bool DirectoryStorage::contains(const QString &absolutePath, const QString &text)
+{
+    SnippetData data;
+    if (m_journal && m_journal->pending(absolutePath, data, /*headerOnly=*/false))
+        return data.contents.contains(text, Qt::CaseInsensitive);
+
+    QFile file(absolutePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    // Line by line, search tokens never span lines
+    int i = 0;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        if (i == BodyLine && line == compressedMarker()) {
+            // A chunk at a time, with an overlap in case a line was too long to end a chunk
+            file.setTextModeEnabled(false);
+            bool found = false;
+            QString overlap;
+            forEachChunk(file, [&](const QByteArray &chunk) {
+                const QString decoded = overlap + QString::fromUtf8(chunk);
+                found = decoded.contains(text, Qt::CaseInsensitive);
+                overlap = decoded.right(text.size() - 1);
+                return !found;
+            });
+            return found;
+        }
+
+        if (i++ > TagsLine && QString::fromUtf8(line).contains(text, Qt::CaseInsensitive))
+            return true;
+    }
+
+    return false;
+}
+
+bool DirectoryStorage::write(const QString &absolutePath, const QString &title,
+                             const QStringList &tags, const QString &contents)
+{
+    // New files are written directly, so listing the folder finds them
+    if (m_journal && QFile::exists(absolutePath) && m_journal->append(absolutePath, title, tags, contents))
+        return true;
+
+    QFile file(absolutePath);
+    if (!writeFile(file, title, tags, contents)) {
+        qWarning() << Q_FUNC_INFO << "Failed to save file" << absolutePath << "because" << file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+/*static*/
+bool DirectoryStorage::writeFile(QFileDevice &file, const QString &title,
+                                 const QStringList &tags, const QString &contents, bool allowCompression)
+{
+    const QByteArray header = serialize(title, tags, QString());
+    const QByteArray body = contents.toUtf8();
+    if (!allowCompression || body.size() < compressionThreshold())
+        return file.open(QIODevice::WriteOnly | QIODevice::Text) && file.write(header + body) != -1;
+
+    if (!file.open(QIODevice::WriteOnly) || file.write(header + compressedMarker()) == -1)
+        return false;
+
+    for (int pos = 0; pos < body.size();) {
+        int end = qMin(pos + int(ChunkBytes), body.size());
+        if (end < body.size()) {
+            // At a line break if possible, else at least not inside a UTF-8 sequence
+            const int newline = body.lastIndexOf('\n', end - 1);
+            if (newline >= pos) {
+                end = newline + 1;
+            } else {
+                while (end > pos + 1 && (uchar(body.at(end)) & 0xC0) == 0x80)
+                    --end;
+            }
+        }
+
+        const QByteArray chunk = qCompress(body.mid(pos, end - pos));
+        QByteArray size(4, Qt::Uninitialized);
+        qToBigEndian<quint32>(quint32(chunk.size()), size.data());
+        if (file.write(size + chunk) == -1)
+            return false;
+
+        pos = end;
+    }
+
+    return true;
+}
+
+bool DirectoryStorage::remove(const QString &absolutePath)
+{
+    if (m_journal)
+        m_journal->forget(absolutePath);
+
+    return QFile::remove(absolutePath);
+}
+
+bool DirectoryStorage::exists(const QString &absolutePath)
+{
+    return QFile::exists(absolutePath);
+}
+
+bool DirectoryStorage::makeFolder(const QString &absolutePath)
+{
+    return QDir().mkpath(absolutePath);
+}
+
+bool DirectoryStorage::renameFolder(const QString &absolutePath, const QString &newAbsolutePath)
+{
+    flush(); // The journal knows snippets by their old path
+    return QDir().rename(absolutePath, newAbsolutePath);
+}
+
+void DirectoryStorage::flush()
+{
+    if (m_journal)
+        m_journal->compact();
+}
+
+bool DirectoryStorage::makeEditable(const QString &absolutePath)
+{
+    flush(); // The editor reads the file, not the journal
+
+    QFile file(absolutePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    file.readLine(); // Title
+    file.readLine(); // Tags
+    if (file.readLine() != compressedMarker())
+        return true;
+    file.close();
+
+    SnippetData data;
+    if (!read(absolutePath, data))
+        return false;
+
+    QSaveFile plain(absolutePath);
+    if (!writeFile(plain, data.title, data.tags, data.contents, /*allowCompression=*/false) || !plain.commit()) {
+        qWarning() << Q_FUNC_INFO << "Failed to decompress" << absolutePath << plain.errorString();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,66 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_DIRECTORY_STORAGE_H
+#define SNIPPY_DIRECTORY_STORAGE_H
+
+#include "snippetstorage.h"
+
+#include <memory>
+
+class Journal;
+class QFileDevice;
+class QLockFile;
+
+// The original layout, one .snip file per snippet and real folders.
+// Easy to edit and sync with other tools, but costs an inode and a few syscalls per snippet.
+// Edits of existing snippets go to a Journal first, see there. Large bodies are compressed.
+// Only one process journals a root, others write the files directly, as before journaling.
+
+class DirectoryStorage : public SnippetStorage
+{
+public:
+    explicit DirectoryStorage(const QString &root);
+    ~DirectoryStorage() override;
+
+    bool list(const QString &folderPath, QStringList &snippetNames, QStringList &subFolders) override;
+    bool read(const QString &absolutePath, SnippetData &data, bool headerOnly = false) override;
+    bool contains(const QString &absolutePath, const QString &text) override;
+    bool write(const QString &absolutePath, const QString &title,
+               const QStringList &tags, const QString &contents) override;
+    bool remove(const QString &absolutePath) override;
+    bool exists(const QString &absolutePath) override;
+    bool makeFolder(const QString &absolutePath) override;
+    bool renameFolder(const QString &absolutePath, const QString &newAbsolutePath) override;
+    void flush() override;
+    bool makeEditable(const QString &absolutePath) override; // Decompresses the file, the next save compresses it again
+
+    // Opens file and writes the snippet, compressed if the body is large, see SNIPPY_COMPRESS_KB
+    static bool writeFile(QFileDevice &file, const QString &title,
+                          const QStringList &tags, const QString &contents, bool allowCompression = true);
+
+private:
+    std::unique_ptr<QLockFile> m_journalLock; // Declared first, released after the journal folded
+    std::unique_ptr<Journal> m_journal; // None for the fallback storage, or if another process journals
+};
+
+#endif
@@ -0,0 +1,695 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "filterquery.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <limits>
+
+enum {
+    MaxNesting = 64 // Parentheses and '!', so a pasted wall of them can't overflow the stack
+};
+
+// Estimated costs, relative to one substring search in a title
+static const double TagCost = 0.5; // A bit test against the resolved tag set
+static const double TextCost = 1;
+static const double AnyCost = 3; // Path, title and tags
+static const double BodyCost = 100; // Loads the body if it isn't cached
+static const double PatternFactor = 2; // A regex or glob over a plain substring search
+
+// The budget of the pass evaluating a pattern term on this thread, see matchPattern()
+static thread_local qint64 *s_patternClock = nullptr;
+
+static bool isDelimiter(QChar c)
+{
+    return c.isSpace() || c == QLatin1Char('&') || c == QLatin1Char('|') || c == QLatin1Char('!')
+           || c == QLatin1Char('(') || c == QLatin1Char(')');
+}
+
+static QString globToRegex(const QString &glob, bool matchesPaths)
+{
+    // Not QRegularExpression::wildcardToRegularExpression(), its '*' stops at '/'
+    QString regex = QStringLiteral("^");
+    // Relative paths start with '/', a glob can't, a leading '/' starts a regex
+    if (matchesPaths)
+        regex += QLatin1String("/?");
+    for (QChar c : glob) {
+        if (c == QLatin1Char('*'))
+            regex += QLatin1String(".*");
+        else if (c == QLatin1Char('?'))
+            regex += QLatin1Char('.');
+        else
+            regex += QRegularExpression::escape(QString(c));
+    }
+
+    return regex + QLatin1Char('$');
+}
+
+bool FilterQuery::Term::isPattern() const
+{
+    return syntax != PlainSyntax;
+}
+
+bool FilterQuery::Term::matches(const QString &value) const
+{
+    if (syntax == PlainSyntax)
+        return value.contains(text, Qt::CaseInsensitive);
+
+    return matchPattern(pattern, value);
+}
+
+bool FilterQuery::matchPattern(const QRegularExpression &pattern, const QString &value)
+{
+    if (!s_patternClock)
+        return pattern.match(value).hasMatch();
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool matched = pattern.match(value).hasMatch();
+    *s_patternClock += timer.nsecsElapsed();
+    return matched;
+}
+
+void FilterQuery::Term::collectSpans(const QString &value, QVector<MatchSpan> &out) const
+{
+    if (syntax == PlainSyntax) {
+        int pos = text.isEmpty() ? -1 : value.indexOf(text, 0, Qt::CaseInsensitive);
+        while (pos != -1) {
+            out.append({ pos, int(text.size()) });
+            pos = value.indexOf(text, pos + text.size(), Qt::CaseInsensitive);
+        }
+        return;
+    }
+
+    QRegularExpressionMatchIterator it = pattern.globalMatch(value);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        if (match.capturedLength() > 0)
+            out.append({ int(match.capturedStart()), int(match.capturedLength()) });
+    }
+}
+
+class FilterQuery::Parser
+{
+public:
+    Parser(const QString &text, QVector<Node> &nodes)
+        : m_text(text)
+        , m_nodes(nodes)
+    {
+    }
+
+    int parse()
+    {
+        next();
+        if (m_token == End)
+            return -1;
+
+        const int root = parseOr(0);
+        if (root != -1 && m_token != End)
+            fail(m_token == RightParen ? QStringLiteral("Unexpected ')'") : QStringLiteral("Expected an operator"));
+
+        return m_error.isEmpty() ? root : -1;
+    }
+
+    QString error() const
+    {
+        return m_error;
+    }
+
+private:
+    enum Token {
+        End,
+        Word,
+        And,
+        Or,
+        Not,
+        LeftParen,
+        RightParen
+    };
+
+    void fail(const QString &message)
+    {
+        if (m_error.isEmpty())
+            m_error = QStringLiteral("%1 at column %2").arg(message).arg(m_tokenStart + 1);
+        m_token = End;
+    }
+
+    QString readQuoted()
+    {
+        // m_pos is on the opening quote
+        const int end = m_text.indexOf(QLatin1Char('"'), m_pos + 1);
+        if (end == -1) {
+            fail(QStringLiteral("Missing closing quote"));
+            return QString();
+        }
+
+        const QString result = m_text.mid(m_pos + 1, end - m_pos - 1);
+        m_pos = end + 1;
+        return result;
+    }
+
+    QString readRegex()
+    {
+        // m_pos is on the opening slash, "\/" doesn't close it
+        int end = m_pos + 1;
+        while (end < m_text.size() && m_text.at(end) != QLatin1Char('/'))
+            end += m_text.at(end) == QLatin1Char('\\') ? 2 : 1;
+
+        if (end >= m_text.size()) {
+            fail(QStringLiteral("Missing closing '/'"));
+            return QString();
+        }
+
+        const QString result = m_text.mid(m_pos + 1, end - m_pos - 1);
+        m_pos = end + 1;
+        return result;
+    }
+
+    void compile(const QString &regex)
+    {
+        // Multi-line, so '^' and '$' work per line of a body
+        m_term.pattern = QRegularExpression(regex, QRegularExpression::CaseInsensitiveOption | QRegularExpression::MultilineOption);
+        if (!m_term.pattern.isValid()) {
+            fail(QStringLiteral("Invalid pattern: %1").arg(m_term.pattern.errorString()));
+            return;
+        }
+
+        m_term.pattern.optimize(); // JIT compiled now rather than on the first match
+    }
+
+    void next()
+    {
+        while (m_pos < m_text.size() && m_text.at(m_pos).isSpace())
+            m_pos++;
+
+        m_tokenStart = m_pos;
+        if (m_pos == m_text.size()) {
+            m_token = End;
+            return;
+        }
+
+        const QChar c = m_text.at(m_pos);
+        const bool doubled = m_pos + 1 < m_text.size() && m_text.at(m_pos + 1) == c;
+        if (c == QLatin1Char('&') || c == QLatin1Char('|')) {
+            m_pos += doubled ? 2 : 1; // "&&" and "||" were accepted when filters were JavaScript
+            m_token = c == QLatin1Char('&') ? And : Or;
+            return;
+        }
+
+        m_pos++;
+        if (c == QLatin1Char('!')) {
+            m_token = Not;
+            return;
+        } else if (c == QLatin1Char('(')) {
+            m_token = LeftParen;
+            return;
+        } else if (c == QLatin1Char(')')) {
+            m_token = RightParen;
+            return;
+        }
+
+        m_pos--;
+        m_token = Word;
+        m_term = Term();
+        readWord();
+    }
+
+    void readWord()
+    {
+        static const struct {
+            const char *prefix;
+            Field field;
+        } qualifiers[] = {
+            { "title:", TitleField },
+            { "tag:", TagField },
+            { "path:", PathField },
+            { "body:", BodyField },
+            { ":", FolderField }
+        };
+
+        QString prefix;
+        for (const auto &qualifier : qualifiers) {
+            const QLatin1String candidate(qualifier.prefix);
+            if (m_text.mid(m_pos, candidate.size()).compare(candidate, Qt::CaseInsensitive) == 0) {
+                m_term.field = qualifier.field;
+                prefix = candidate;
+                m_pos += candidate.size();
+                break;
+            }
+        }
+
+        if (m_pos < m_text.size() && m_text.at(m_pos) == QLatin1Char('"')) {
+            m_term.text = readQuoted().toLower();
+        } else if (m_pos < m_text.size() && m_text.at(m_pos) == QLatin1Char('/')) {
+            m_term.syntax = RegexSyntax;
+            m_term.text = readRegex();
+            if (!m_term.text.isEmpty())
+                compile(m_term.text);
+        } else {
+            const int start = m_pos;
+            while (m_pos < m_text.size() && !isDelimiter(m_text.at(m_pos)))
+                m_pos++;
+            m_term.text = m_text.mid(start, m_pos - start);
+
+            const bool matchesPaths = m_term.field == AnyField || m_term.field == PathField || m_term.field == FolderField;
+            if (matchesPaths) {
+                // "foo/" means the folder foo, trailing separators aren't in the paths
+                while (m_term.text.endsWith(QLatin1Char('/')) || m_term.text.endsWith(QLatin1Char('\\')))
+                    m_term.text.chop(1);
+            }
+
+            if (m_term.text.contains(QLatin1Char('*')) || m_term.text.contains(QLatin1Char('?'))) {
+                m_term.syntax = GlobSyntax;
+                compile(globToRegex(m_term.text, matchesPaths));
+            } else {
+                m_term.text = m_term.text.toLower();
+            }
+        }
+
+        if (m_term.text.isEmpty() && m_error.isEmpty())
+            fail(QStringLiteral("Missing text after '%1'").arg(prefix));
+    }
+
+    int append(Kind kind, const QVector<int> &children)
+    {
+        // Flattens "a & (b & c)", the planner can then order all three
+        Node node;
+        node.kind = kind;
+        for (int child : children) {
+            if (m_nodes.at(child).kind == kind && kind != NotNode)
+                node.children += m_nodes.at(child).children;
+            else
+                node.children.append(child);
+        }
+
+        m_nodes.append(node);
+        return m_nodes.size() - 1;
+    }
+
+    int parseOr(int depth)
+    {
+        QVector<int> operands = { parseAnd(depth) };
+        while (m_token == Or) {
+            next();
+            operands.append(parseAnd(depth));
+        }
+
+        if (!m_error.isEmpty())
+            return -1;
+
+        return operands.size() == 1 ? operands.first() : append(OrNode, operands);
+    }
+
+    int parseAnd(int depth)
+    {
+        QVector<int> operands = { parseUnary(depth) };
+        while (m_token == And || m_token == Word || m_token == Not || m_token == LeftParen) {
+            if (m_token == And)
+                next();
+            operands.append(parseUnary(depth));
+        }
+
+        if (!m_error.isEmpty())
+            return -1;
+
+        return operands.size() == 1 ? operands.first() : append(AndNode, operands);
+    }
+
+    int parseUnary(int depth)
+    {
+        if (depth > MaxNesting) {
+            fail(QStringLiteral("Too deeply nested"));
+            return -1;
+        }
+
+        switch (m_token) {
+        case Not: {
+            next();
+            const int operand = parseUnary(depth + 1);
+            if (operand == -1)
+                return -1;
+            if (m_nodes.at(operand).kind == NotNode)
+                return m_nodes.at(operand).children.first(); // "!!a"
+            return append(NotNode, { operand });
+        }
+        case LeftParen: {
+            next();
+            const int operand = parseOr(depth + 1);
+            if (operand == -1)
+                return -1;
+            if (m_token != RightParen) {
+                fail(QStringLiteral("Missing ')'"));
+                return -1;
+            }
+            next();
+            return operand;
+        }
+        case Word: {
+            Node node;
+            node.term = m_term;
+            m_nodes.append(node);
+            next();
+            return m_nodes.size() - 1;
+        }
+        default:
+            fail(m_token == End ? QStringLiteral("Expected a term at the end") : QStringLiteral("Expected a term"));
+            return -1;
+        }
+    }
+
+    const QString &m_text;
+    QVector<Node> &m_nodes;
+    QString m_error;
+    Token m_token = End;
+    Term m_term;
+    int m_pos = 0;
+    int m_tokenStart = 0;
+};
+
+FilterQuery::FilterQuery(const QString &text)
+    : m_text(text)
+{
+    Parser parser(text, m_nodes);
+    m_root = parser.parse();
+    m_error = parser.error();
+    if (!m_error.isEmpty())
+        m_nodes.clear();
+}
+
+bool FilterQuery::isEmpty() const
+{
+    return m_root == -1;
+}
+
+bool FilterQuery::isValid() const
+{
+    return m_error.isEmpty();
+}
+
+QString FilterQuery::errorString() const
+{
+    return m_error;
+}
+
+void FilterQuery::plan(const Statistics &statistics)
+{
+    if (m_root != -1)
+        plan(m_root, statistics);
+}
+
+void FilterQuery::plan(int index, const Statistics &statistics)
+{
+    Node &node = m_nodes[index];
+    switch (node.kind) {
+    case TermNode: {
+        // Without better knowledge, longer text is assumed to match less
+        const double textSelectivity = qBound(0.01, 0.5 / node.term.text.size(), 0.5);
+        const double factor = node.term.isPattern() ? PatternFactor : 1;
+        switch (node.term.field) {
+        case TagField:
+            node.cost = TagCost;
+            if (statistics.snippetCount > 0 && statistics.tagUsage)
+                node.selectivity = qMin(1.0, double(statistics.tagUsage(node.term)) / statistics.snippetCount);
+            else
+                node.selectivity = textSelectivity;
+            break;
+        case TitleField:
+        case PathField:
+        case FolderField:
+            node.cost = TextCost * factor;
+            node.selectivity = textSelectivity;
+            break;
+        case AnyField:
+            node.cost = (AnyCost + (statistics.deepSearch ? BodyCost : 0)) * factor;
+            node.selectivity = qMin(1.0, textSelectivity * (statistics.deepSearch ? 4 : 2));
+            break;
+        case BodyField:
+            node.cost = BodyCost * factor;
+            node.selectivity = qMin(1.0, textSelectivity * 3);
+            break;
+        }
+        return;
+    }
+    case NotNode:
+        plan(node.children.first(), statistics);
+        node.cost = m_nodes.at(node.children.first()).cost;
+        node.selectivity = 1 - m_nodes.at(node.children.first()).selectivity;
+        return;
+    case AndNode:
+    case OrNode:
+        break;
+    }
+
+    for (int child : node.children)
+        plan(child, statistics);
+
+    // Evaluating independent predicates in order of cost over the chance of deciding the result
+    // minimises the expected cost. An '&' is decided by a term failing, an '|' by one passing.
+    const bool isAnd = node.kind == AndNode;
+    auto rank = [this, isAnd](int index) {
+        const Node &child = m_nodes.at(index);
+        const double decides = isAnd ? 1 - child.selectivity : child.selectivity;
+        return decides <= 0 ? std::numeric_limits<double>::max() : child.cost / decides;
+    };
+    std::stable_sort(node.children.begin(), node.children.end(), [&rank](int a, int b) {
+        return rank(a) < rank(b);
+    });
+
+    double reached = 1; // Chance that evaluation gets to the next child
+    node.cost = 0;
+    for (int child : node.children) {
+        const Node &c = m_nodes.at(child);
+        node.cost += reached * c.cost;
+        reached *= isAnd ? c.selectivity : 1 - c.selectivity;
+    }
+    node.selectivity = isAnd ? reached : 1 - reached;
+}
+
+bool FilterQuery::matches(const TermMatcher &matcher) const
+{
+    return m_root == -1 || matches(m_root, matcher);
+}
+
+bool FilterQuery::matches(int index, const TermMatcher &matcher) const
+{
+    const Node &node = m_nodes.at(index);
+    bool result = true;
+    switch (node.kind) {
+    case TermNode: {
+        if (node.term.isPattern()) {
+            if (m_patternBudget >= 0 && m_patternNanoseconds > m_patternBudget) {
+                result = false;
+                break;
+            }
+            // Only the matching is charged, reading a body from disk isn't the pattern's fault
+            s_patternClock = &m_patternNanoseconds;
+        }
+
+        // Only terms are timed, the operators cost next to nothing on top
+        if (m_timing) {
+            QElapsedTimer timer;
+            timer.start();
+            result = matcher(node.term);
+            node.nanoseconds += timer.nsecsElapsed();
+        } else {
+            result = matcher(node.term);
+        }
+        s_patternClock = nullptr;
+        break;
+    }
+    case NotNode:
+        result = !matches(node.children.first(), matcher);
+        break;
+    case AndNode:
+        for (int child : node.children) {
+            if (!matches(child, matcher)) {
+                result = false;
+                break;
+            }
+        }
+        break;
+    case OrNode:
+        result = false;
+        for (int child : node.children) {
+            if (matches(child, matcher)) {
+                result = true;
+                break;
+            }
+        }
+        break;
+    }
+
+    node.evaluations++;
+    if (result)
+        node.passes++;
+
+    return result;
+}
+
+void FilterQuery::startPass(int budgetMs)
+{
+    m_patternBudget = budgetMs * qint64(1000000);
+    m_patternNanoseconds = 0;
+}
+
+void FilterQuery::setTimingEnabled(bool enabled)
+{
+    m_timing = enabled;
+}
+
+bool FilterQuery::timedOut() const
+{
+    return m_patternBudget >= 0 && m_patternNanoseconds > m_patternBudget;
+}
+
+QVector<FilterQuery::Term> FilterQuery::positiveTerms() const
+{
+    QVector<Term> terms;
+    if (m_root != -1)
+        collectPositiveTerms(m_root, terms);
+
+    return terms;
+}
+
+void FilterQuery::collectPositiveTerms(int index, QVector<Term> &out) const
+{
+    const Node &node = m_nodes.at(index);
+    if (node.kind == TermNode) {
+        out.append(node.term);
+    } else if (node.kind != NotNode) {
+        for (int child : node.children)
+            collectPositiveTerms(child, out);
+    }
+}
+
+QVector<MatchSpan> FilterQuery::matchSpans(const QVector<Term> &terms, const QString &value)
+{
+    QVector<MatchSpan> spans;
+    for (const Term &term : terms)
+        term.collectSpans(value, spans);
+
+    std::sort(spans.begin(), spans.end(), [](const MatchSpan &a, const MatchSpan &b) {
+        return a.start < b.start;
+    });
+
+    QVector<MatchSpan> merged;
+    for (const MatchSpan &span : spans) {
+        if (!merged.isEmpty() && span.start <= merged.last().start + merged.last().length) {
+            MatchSpan &last = merged.last();
+            last.length = qMax(last.length, span.start + span.length - last.start);
+        } else {
+            merged.append(span);
+        }
+    }
+
+    return merged;
+}
+
+void FilterQuery::resetStatistics()
+{
+    for (const Node &node : m_nodes) {
+        node.evaluations = 0;
+        node.passes = 0;
+        node.nanoseconds = 0;
+    }
+}
+
+QString FilterQuery::termText(const Term &term)
+{
+    static const char *const prefixes[] = { "", "title:", "tag:", "path:", "body:", ":" };
+    QString text = term.text;
+    if (term.syntax == RegexSyntax)
+        text = QLatin1Char('/') + text + QLatin1Char('/');
+    else if (std::any_of(text.cbegin(), text.cend(), isDelimiter))
+        text = QLatin1Char('"') + text + QLatin1Char('"');
+
+    return QLatin1String(prefixes[term.field]) + text;
+}
+
+QString FilterQuery::explain() const
+{
+    if (!m_error.isEmpty())
+        return QStringLiteral("Invalid filter \"%1\": %2").arg(m_text, m_error);
+
+    if (m_root == -1)
+        return QStringLiteral("No filter");
+
+    const Node &root = m_nodes.at(m_root);
+    QString out = QStringLiteral("Filter: ") + m_text + QLatin1Char('\n');
+    out += QStringLiteral("Estimated cost per snippet %1, estimated to pass %2%\n")
+               .arg(root.cost, 0, 'f', 1)
+               .arg(root.selectivity * 100, 0, 'f', 1);
+    if (timedOut())
+        out += QStringLiteral("Stopped, patterns took longer than their time budget\n");
+    out += QStringLiteral("Operands run top to bottom, cost is relative to a title search\n\n");
+    explain(m_root, 0, out);
+    return out;
+}
+
+void FilterQuery::explain(int index, int depth, QString &out) const
+{
+    const Node &node = m_nodes.at(index);
+    QString label;
+    switch (node.kind) {
+    case TermNode:
+        label = termText(node.term);
+        break;
+    case AndNode:
+        label = QStringLiteral("&");
+        break;
+    case OrNode:
+        label = QStringLiteral("|");
+        break;
+    case NotNode:
+        label = QStringLiteral("!");
+        break;
+    }
+
+    qint64 nanoseconds = node.nanoseconds;
+    if (node.kind != TermNode) {
+        // Terms are the only ones timed
+        QVector<int> pending = node.children;
+        while (!pending.isEmpty()) {
+            const Node &descendant = m_nodes.at(pending.takeLast());
+            nanoseconds += descendant.nanoseconds;
+            pending += descendant.children;
+        }
+    }
+
+    const double passRate = node.evaluations > 0 ? 100.0 * node.passes / node.evaluations : 0;
+    // The label is user text, it's not passed through arg() where a "%1" in it would be replaced
+    out += QString(depth * 2, QLatin1Char(' ')) + label.leftJustified(24 - depth * 2);
+    out += QStringLiteral("  est. cost %1, est. pass %2% | ran %3, passed %4 (%5%)")
+               .arg(node.cost, 0, 'f', 1)
+               .arg(node.selectivity * 100, 0, 'f', 1)
+               .arg(node.evaluations)
+               .arg(node.passes)
+               .arg(passRate, 0, 'f', 1);
+    if (m_timing)
+        out += QStringLiteral(", %1 ms").arg(nanoseconds / 1000000.0, 0, 'f', 2);
+    out += QLatin1Char('\n');
+
+    for (int child : node.children)
+        explain(child, depth + 1, out);
+}
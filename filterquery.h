@@ -0,0 +1,172 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_FILTER_QUERY_H
+#define SNIPPY_FILTER_QUERY_H
+
+#include <QMetaType>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+// The line edit's filter, like: "docker & (tag:k8s | !title:old)"
+//
+// Terms are bare words, matched against path, title, tags and in deep mode the body, or are
+// qualified with "title:", "tag:", "path:" or "body:". A leading ':' still means folders only.
+// Quotes keep spaces and operators inside a term. Terms next to each other are and'ed.
+// "/^kubectl (get|describe)/" is a regex and an unquoted term with '*' or '?' a glob, like
+// "docker-*". Globs match whole values: a title, a tag, a path or a line of the body. Paths
+// start with '/', for globs it's optional.
+// '!' binds tighter than '&', which binds tighter than '|'.
+//
+// plan() reorders the operands of each '&' and '|' so that cheap terms likely to decide the
+// result run first. Evaluation short-circuits, so body scans only run on what got past them.
+
+// Where a term matched within a title or a body, in QChars
+struct MatchSpan
+{
+    int start = 0;
+    int length = 0;
+
+    bool operator==(const MatchSpan &other) const
+    {
+        return start == other.start && length == other.length;
+    }
+};
+
+Q_DECLARE_METATYPE(MatchSpan)
+
+class FilterQuery
+{
+public:
+    enum Field {
+        AnyField = 0,
+        TitleField,
+        TagField,
+        PathField,
+        BodyField,
+        FolderField // The ':' prefix
+    };
+
+    enum Syntax {
+        PlainSyntax = 0, // Case insensitive substring
+        RegexSyntax,
+        GlobSyntax
+    };
+
+    struct Term
+    {
+        Field field = AnyField;
+        Syntax syntax = PlainSyntax;
+        QString text; // As typed, lower case for plain terms
+        QRegularExpression pattern; // Regex and glob terms, compiled once when parsed
+
+        bool isPattern() const;
+        bool matches(const QString &value) const;
+        void collectSpans(const QString &value, QVector<MatchSpan> &out) const;
+    };
+
+    // What the planner needs to know about the corpus
+    struct Statistics
+    {
+        int snippetCount = 0;
+        bool deepSearch = false;
+        std::function<int(const Term &)> tagUsage; // Snippets having a tag the term matches
+    };
+
+    using TermMatcher = std::function<bool(const Term &)>;
+
+    FilterQuery() = default;
+    explicit FilterQuery(const QString &text);
+
+    bool isEmpty() const;
+    bool isValid() const;
+    QString errorString() const;
+
+    void plan(const Statistics &);
+    bool matches(const TermMatcher &) const;
+
+    // Patterns can backtrack for a very long time. Once matching them took more than budgetMs
+    // since startPass(), they stop running and match nothing, and timedOut() says so.
+    void startPass(int budgetMs);
+    bool timedOut() const;
+
+    // What term matchers run patterns with, bodies included. While a pattern term is being
+    // evaluated the time it takes is charged to the pass's budget, reading the body isn't.
+    static bool matchPattern(const QRegularExpression &, const QString &value);
+
+    // Terms that have to be present for a match, for highlighting. Negated ones aren't.
+    QVector<Term> positiveTerms() const;
+
+    // Where any of the terms match value, sorted and with overlapping spans merged
+    static QVector<MatchSpan> matchSpans(const QVector<Term> &, const QString &value);
+
+    // The plan with its estimates, and what each node cost and matched since resetStatistics()
+    QString explain() const;
+    void resetStatistics();
+
+    // Terms are only timed for explain() while enabled, a tag test is cheaper than its timer
+    void setTimingEnabled(bool);
+
+private:
+    enum Kind {
+        TermNode,
+        AndNode,
+        OrNode,
+        NotNode
+    };
+
+    struct Node
+    {
+        Kind kind = TermNode;
+        Term term;
+        QVector<int> children; // Indexes into m_nodes, in evaluation order once planned
+        double cost = 0; // Estimated, in units of a title comparison
+        double selectivity = 1; // Estimated fraction of snippets passing
+
+        // Measured, matches() is const to the callers but not to these
+        mutable qint64 evaluations = 0;
+        mutable qint64 passes = 0;
+        mutable qint64 nanoseconds = 0;
+    };
+
+    class Parser;
+
+    bool matches(int node, const TermMatcher &) const;
+    void plan(int node, const Statistics &);
+    void explain(int node, int depth, QString &out) const;
+    void collectPositiveTerms(int node, QVector<Term> &out) const;
+    static QString termText(const Term &);
+
+    QString m_text;
+    QString m_error;
+    QVector<Node> m_nodes;
+    int m_root = -1;
+    bool m_timing = false;
+    qint64 m_patternBudget = -1; // Nanoseconds, -1 for none
+    mutable qint64 m_patternNanoseconds = 0;
+};
+
+#endif
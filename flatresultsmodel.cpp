@@ -0,0 +1,216 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "flatresultsmodel.h"
+#include "snippetmodel.h"
+#include "snippetproxymodel.h"
+#include "tracer.h"
+
+#include <QSet>
+
+#include <algorithm>
+
+FlatResultsModel::FlatResultsModel(SnippetProxyModel *filterModel, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_filterModel(filterModel)
+    , m_model(qobject_cast<SnippetModel *>(filterModel->sourceModel()))
+{
+    // Snippets arrive in chunks while loading, one walk per event loop run is enough
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(0);
+    connect(&m_updateTimer, &QTimer::timeout, this, &FlatResultsModel::update);
+
+    connect(m_filterModel, &SnippetProxyModel::matchesChanged, this, &FlatResultsModel::scheduleUpdate);
+    connect(m_filterModel, &SnippetProxyModel::sortOrderChanged, this, &FlatResultsModel::scheduleUpdate);
+    connect(m_model, &QAbstractItemModel::rowsInserted, this, &FlatResultsModel::scheduleUpdate);
+    connect(m_model, &QAbstractItemModel::modelReset, this, &FlatResultsModel::scheduleUpdate);
+    connect(m_model, &QAbstractItemModel::dataChanged, this, &FlatResultsModel::onSourceDataChanged);
+
+    // Right away, the rows would point to deleted items until the next update
+    connect(m_model, &QAbstractItemModel::rowsRemoved, this, &FlatResultsModel::update);
+    connect(m_model, &QAbstractItemModel::modelAboutToBeReset, this, [this] {
+        beginResetModel();
+        m_rows.clear();
+        endResetModel();
+    });
+}
+
+int FlatResultsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+QString FlatResultsModel::folderPrefix(const QModelIndex &sourceIndex)
+{
+    // Like "docker/", snippets at the top have none
+    QString path = sourceIndex.parent().data(SnippetModel::RelativePathRole).toString();
+    if (path.startsWith(QLatin1Char('/')))
+        path.remove(0, 1);
+    return path.isEmpty() ? path : path + QLatin1Char('/');
+}
+
+QVariant FlatResultsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size())
+        return QVariant();
+
+    const QModelIndex sourceIndex = m_rows.at(index.row())->index();
+    switch (role) {
+    case Qt::DisplayRole:
+        return folderPrefix(sourceIndex) + sourceIndex.data(Qt::DisplayRole).toString();
+    case Qt::ToolTipRole:
+        return sourceIndex.data(SnippetModel::RelativePathRole);
+    case Qt::FontRole:
+    case Qt::DecorationRole:
+        return QVariant();
+    case SnippetModel::TitleMatchSpansRole: {
+        // Within the title, which is shown after the folder
+        const QVariant titleSpans = m_filterModel->mapFromSource(sourceIndex).data(role);
+        QVector<MatchSpan> spans = titleSpans.value<QVector<MatchSpan>>();
+        if (spans.isEmpty())
+            return titleSpans;
+
+        const int offset = folderPrefix(sourceIndex).size();
+        for (MatchSpan &span : spans)
+            span.start += offset;
+        return QVariant::fromValue(spans);
+    }
+    }
+
+    return sourceIndex.data(role);
+}
+
+bool FlatResultsModel::isActive() const
+{
+    return m_active;
+}
+
+void FlatResultsModel::setActive(bool active)
+{
+    if (active == m_active)
+        return;
+
+    m_active = active;
+    if (m_active) {
+        update();
+    } else {
+        m_updateTimer.stop();
+        beginResetModel();
+        m_rows.clear();
+        endResetModel();
+    }
+}
+
+QModelIndex FlatResultsModel::mapToSource(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size())
+        return QModelIndex();
+
+    return m_rows.at(index.row())->index();
+}
+
+QModelIndex FlatResultsModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    const int row = m_rows.indexOf(m_model->itemFromIndex(sourceIndex));
+    return row == -1 ? QModelIndex() : index(row);
+}
+
+void FlatResultsModel::scheduleUpdate()
+{
+    if (m_active)
+        m_updateTimer.start();
+}
+
+void FlatResultsModel::onSourceDataChanged()
+{
+    // A rename changes the paths shown, and maybe the matches
+    m_dataChanged = true;
+    scheduleUpdate();
+}
+
+void FlatResultsModel::update()
+{
+    if (!m_active)
+        return;
+
+    SNIPPY_TRACE("FlatResultsModel::update");
+    m_updateTimer.stop();
+    QVector<const QStandardItem *> rows = m_filterModel->matchingSnippets();
+    if (m_filterModel->sortOrder() != SnippetProxyModel::FolderOrder) {
+        // Stable, so ties stay in tree order
+        std::stable_sort(rows.begin(), rows.end(), [this](const QStandardItem *left, const QStandardItem *right) {
+            return m_filterModel->snippetLessThan(left, right);
+        });
+    }
+
+    // Both lists are in the same order, so one merge finds the runs to remove and to insert,
+    // keeping the selection and scroll position. Only pointers are compared, rows can point
+    // to items deleted just now.
+    QSet<const QStandardItem *> wanted;
+    wanted.reserve(rows.size());
+    for (const QStandardItem *item : rows)
+        wanted.insert(item);
+
+    QSet<const QStandardItem *> current;
+    current.reserve(m_rows.size());
+    for (const QStandardItem *item : m_rows)
+        current.insert(item);
+
+    int i = 0; // Into m_rows, as it's being edited
+    int j = 0; // Into rows
+    while (i < m_rows.size() || j < rows.size()) {
+        if (i < m_rows.size() && j < rows.size() && m_rows.at(i) == rows.at(j)) {
+            ++i;
+            ++j;
+        } else if (i < m_rows.size() && !wanted.contains(m_rows.at(i))) {
+            int end = i + 1;
+            while (end < m_rows.size() && !wanted.contains(m_rows.at(end)))
+                ++end;
+
+            beginRemoveRows(QModelIndex(), i, end - 1);
+            m_rows.remove(i, end - i);
+            endRemoveRows();
+        } else if (j < rows.size() && !current.contains(rows.at(j))) {
+            int end = j + 1;
+            while (end < rows.size() && !current.contains(rows.at(end)))
+                ++end;
+
+            beginInsertRows(QModelIndex(), i, i + end - j - 1);
+            m_rows.insert(i, end - j, nullptr);
+            std::copy(rows.cbegin() + j, rows.cbegin() + end, m_rows.begin() + i);
+            endInsertRows();
+            i += end - j;
+            j = end;
+        } else {
+            // Something moved, not worth a smarter diff
+            beginResetModel();
+            m_rows = rows;
+            endResetModel();
+            m_dataChanged = false;
+            return;
+        }
+    }
+
+    if (m_dataChanged && !m_rows.isEmpty())
+        emit dataChanged(index(0), index(m_rows.size() - 1));
+    m_dataChanged = false;
+}
@@ -0,0 +1,68 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_FLAT_RESULTS_MODEL_H
+#define SNIPPY_FLAT_RESULTS_MODEL_H
+
+#include <QAbstractListModel>
+#include <QTimer>
+#include <QVector>
+
+class QStandardItem;
+class SnippetModel;
+class SnippetProxyModel;
+
+// The snippets passing the filter as a plain list, in tree order unless the filter model sorts, for when there are too many
+// to expand the tree for. Rows only hold item pointers, everything shown is asked for in data(),
+// so the cost of a change is that of walking the matches, not of laying out rows.
+// Every snippet is listed when there's no filter. Does nothing while inactive.
+
+class FlatResultsModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit FlatResultsModel(SnippetProxyModel *filterModel, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    bool isActive() const;
+    void setActive(bool);
+
+    QModelIndex mapToSource(const QModelIndex &index) const; // To SnippetModel
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const;
+
+private:
+    static QString folderPrefix(const QModelIndex &sourceIndex);
+    void scheduleUpdate();
+    void update();
+    void onSourceDataChanged();
+
+    SnippetProxyModel *const m_filterModel;
+    SnippetModel *const m_model;
+    QVector<const QStandardItem *> m_rows;
+    QTimer m_updateTimer;
+    bool m_active = false;
+    bool m_dataChanged = false;
+};
+
+#endif
@@ -0,0 +1,364 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "journal.h"
+#include "directorystorage.h"
+#include "tracer.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QThread>
+#include <QtEndian>
+
+enum {
+    CompactIntervalMs = 30 * 1000,
+    CompactJournalBytes = 4 * 1024 * 1024, // Wakes the compactor early
+    FrameHeaderSize = 8, // Payload size, checksum and padding, little-endian
+    StreamVersion = QDataStream::Qt_5_12
+};
+
+static quint16 checksum(const QByteArray &bytes)
+{
+#ifdef OPTION_QT6
+    return qChecksum(bytes);
+#else
+    return qChecksum(bytes.constData(), uint(bytes.size()));
+#endif
+}
+
+static QByteArray frame(const QByteArray &payload)
+{
+    QByteArray result(FrameHeaderSize, '\0');
+    qToLittleEndian<quint32>(quint32(payload.size()), result.data());
+    qToLittleEndian<quint16>(checksum(payload), result.data() + 4);
+    return result + payload;
+}
+
+Journal::Journal(const QString &rootPath)
+    : m_rootPath(rootPath)
+    , m_journalPath(rootPath + QStringLiteral("/.snippy-journal"))
+    , m_rotatedPath(rootPath + QStringLiteral("/.snippy-journal.1"))
+    , m_stopping(false)
+{
+    // Whatever a previous run didn't fold, older generation first
+    replay(m_rotatedPath);
+    replay(m_journalPath);
+
+    if (!m_pending.isEmpty()) {
+        qDebug() << Q_FUNC_INFO << "Folding" << m_pending.size() << "journaled snippets into" << rootPath;
+        m_pending = writeSnippets(m_pending);
+
+        // What couldn't be written is kept, the journal is replaced atomically
+        QSaveFile file(m_journalPath);
+        if (file.open(QIODevice::WriteOnly)) {
+            for (auto it = m_pending.cbegin(), end = m_pending.cend(); it != end; ++it)
+                file.write(frame(fullRecord(it.key(), it.value())));
+            if (file.commit())
+                QFile::remove(m_rotatedPath);
+        }
+    } else {
+        // Nothing worth keeping, and records appended after a torn tail would never replay
+        QFile::remove(m_rotatedPath);
+        QFile::remove(m_journalPath);
+    }
+
+    openJournal();
+    m_thread = QThread::create([this] {
+        runCompactor();
+    });
+    m_thread->start(QThread::LowPriority);
+}
+
+Journal::~Journal()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wakeUp.wakeOne();
+    }
+
+    m_thread->wait();
+    delete m_thread;
+    compact();
+}
+
+bool Journal::append(const QString &absolutePath, const QString &title,
+                     const QStringList &tags, const QString &contents)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.isOpen())
+        return false;
+
+    const QString key = this->key(absolutePath);
+    State state;
+    state.title = title;
+    state.tags = tags;
+    state.contents = contents;
+    state.saved = QDateTime::currentMSecsSinceEpoch();
+
+    QByteArray payload;
+    auto it = m_pending.constFind(key);
+    if (it == m_pending.cend()) {
+        payload = fullRecord(key, state);
+        state.fileModified = QFileInfo(absolutePath).lastModified().toMSecsSinceEpoch();
+    } else {
+        state.fileModified = it->fileModified;
+        // Only the changed middle, typing touches a small part of a big body
+        const QString &old = it->contents;
+        const int common = qMin(old.size(), contents.size());
+        int prefix = 0;
+        while (prefix < common && old.at(prefix) == contents.at(prefix))
+            ++prefix;
+        int suffix = 0;
+        while (suffix < common - prefix && old.at(old.size() - 1 - suffix) == contents.at(contents.size() - 1 - suffix))
+            ++suffix;
+
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out.setVersion(StreamVersion);
+        out << quint8(DeltaRecord) << key << title << tags << qint32(prefix) << qint32(suffix)
+            << contents.mid(prefix, contents.size() - prefix - suffix);
+    }
+
+    if (!writeRecord(payload)) {
+        m_pending.remove(key); // The caller writes the file directly, don't shadow it
+        return false;
+    }
+
+    m_pending.insert(key, state);
+    if (m_file.size() > CompactJournalBytes)
+        m_wakeUp.wakeOne();
+
+    return true;
+}
+
+bool Journal::pending(const QString &absolutePath, SnippetData &data, bool headerOnly)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_pending.isEmpty() && m_compacting.isEmpty())
+        return false;
+
+    const QString key = this->key(absolutePath);
+    auto it = m_pending.constFind(key);
+    if (it == m_pending.cend()) {
+        it = m_compacting.constFind(key);
+        if (it == m_compacting.cend())
+            return false;
+    }
+
+    data.absolutePath = absolutePath;
+    data.title = it->title;
+    data.tags = it->tags;
+    data.hasContents = !headerOnly;
+    if (!headerOnly)
+        data.contents = it->contents;
+
+    return true;
+}
+
+void Journal::forget(const QString &absolutePath)
+{
+    QMutexLocker compactLocker(&m_compactMutex); // So it isn't being written right now
+    QMutexLocker locker(&m_mutex);
+    const QString key = this->key(absolutePath);
+    if (!m_pending.remove(key))
+        return;
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(StreamVersion);
+    out << quint8(RemoveRecord) << key;
+    writeRecord(payload);
+}
+
+void Journal::compact()
+{
+    QMutexLocker compactLocker(&m_compactMutex);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_pending.isEmpty())
+            return;
+
+        // Saves continue into a new generation meanwhile, starting with full records
+        m_compacting.swap(m_pending);
+        m_file.close();
+        QFile::remove(m_rotatedPath);
+        if (!QFile::rename(m_journalPath, m_rotatedPath))
+            qWarning() << Q_FUNC_INFO << "Failed to rotate" << m_journalPath; // Keeps appending to it, still replays fine
+        openJournal();
+    }
+
+    SNIPPY_TRACE_ARGS("Journal::compact", QString::number(m_compacting.size()));
+    const QHash<QString, State> failed = writeSnippets(m_compacting); // Only this thread changes it
+
+    QMutexLocker locker(&m_mutex);
+    for (auto it = failed.cbegin(), end = failed.cend(); it != end; ++it) {
+        // Retried next time, unless it was saved again meanwhile
+        if (!m_pending.contains(it.key()) && writeRecord(fullRecord(it.key(), it.value())))
+            m_pending.insert(it.key(), it.value());
+    }
+
+    // Saved again while this ran, what was just written is ours and not another process'
+    for (auto it = m_pending.begin(), end = m_pending.end(); it != end; ++it) {
+        if (m_compacting.contains(it.key()) && !failed.contains(it.key()))
+            it->fileModified = QFileInfo(m_rootPath + QLatin1Char('/') + it.key()).lastModified().toMSecsSinceEpoch();
+    }
+
+    m_compacting.clear();
+    QFile::remove(m_rotatedPath);
+}
+
+void Journal::replay(const QString &journalPath)
+{
+    QFile file(journalPath);
+    if (!file.exists())
+        return;
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << Q_FUNC_INFO << "Failed to open" << journalPath << file.errorString();
+        return;
+    }
+
+    const QByteArray bytes = file.readAll();
+    int pos = 0;
+    while (pos + FrameHeaderSize <= bytes.size()) {
+        const qint64 size = qFromLittleEndian<quint32>(bytes.constData() + pos);
+        if (pos + FrameHeaderSize + size > bytes.size())
+            break;
+
+        const QByteArray payload = bytes.mid(pos + FrameHeaderSize, int(size));
+        if (checksum(payload) != qFromLittleEndian<quint16>(bytes.constData() + pos + 4))
+            break;
+        pos += FrameHeaderSize + int(size);
+
+        QDataStream in(payload);
+        in.setVersion(StreamVersion);
+        quint8 type = 0;
+        QString key;
+        in >> type >> key;
+        if (type == RemoveRecord) {
+            m_pending.remove(key);
+            continue;
+        }
+
+        State state;
+        in >> state.title >> state.tags;
+        if (type == FullRecord) {
+            in >> state.contents;
+        } else if (type == DeltaRecord) {
+            qint32 prefix = 0;
+            qint32 suffix = 0;
+            QString middle;
+            in >> prefix >> suffix >> middle;
+            auto it = m_pending.constFind(key);
+            if (it == m_pending.cend() || prefix < 0 || suffix < 0 || prefix + suffix > it->contents.size()) {
+                qWarning() << Q_FUNC_INFO << "Skipping an edit without a base for" << key;
+                continue;
+            }
+            state.contents = it->contents.left(prefix) + middle + it->contents.right(suffix);
+        } else {
+            break;
+        }
+
+        m_pending.insert(key, state);
+    }
+
+    if (pos != bytes.size())
+        qWarning() << Q_FUNC_INFO << "Ignoring a torn or corrupt tail of" << journalPath;
+}
+
+void Journal::openJournal()
+{
+    m_file.setFileName(m_journalPath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append))
+        qWarning() << Q_FUNC_INFO << "Failed to open" << m_journalPath << m_file.errorString() << ", saving directly";
+}
+
+bool Journal::writeRecord(const QByteArray &payload)
+{
+    const QByteArray bytes = frame(payload);
+
+    // All or nothing, a torn record would hide the ones appended after it
+    const qint64 size = m_file.size();
+    if (m_file.write(bytes) != bytes.size() || !m_file.flush()) {
+        qWarning() << Q_FUNC_INFO << "Failed to write" << m_journalPath << m_file.errorString();
+        m_file.resize(size);
+        return false;
+    }
+
+    return true;
+}
+
+QByteArray Journal::fullRecord(const QString &key, const State &state) const
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(StreamVersion);
+    out << quint8(FullRecord) << key << state.title << state.tags << state.contents;
+    return payload;
+}
+
+QHash<QString, Journal::State> Journal::writeSnippets(const QHash<QString, State> &states) const
+{
+    QHash<QString, State> failed;
+    for (auto it = states.cbegin(), end = states.cend(); it != end; ++it) {
+        const QString path = m_rootPath + QLatin1Char('/') + it.key();
+        if (it->fileModified >= 0) {
+            const qint64 modified = QFileInfo(path).lastModified().toMSecsSinceEpoch();
+            if (modified != it->fileModified && modified > it->saved) {
+                qWarning() << Q_FUNC_INFO << path << "was saved by another process since, keeping that";
+                continue;
+            }
+        }
+
+        // Atomically, a crash leaves either the old or the new file
+        QSaveFile file(path);
+        if (!DirectoryStorage::writeFile(file, it->title, it->tags, it->contents) || !file.commit()) {
+            qWarning() << Q_FUNC_INFO << "Failed to write" << file.fileName() << file.errorString();
+            failed.insert(it.key(), it.value());
+        }
+    }
+
+    return failed;
+}
+
+QString Journal::key(const QString &absolutePath) const
+{
+    return absolutePath.mid(m_rootPath.size() + 1);
+}
+
+void Journal::runCompactor()
+{
+    Tracer::setThreadName(QStringLiteral("journal"));
+    while (!m_stopping) {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!m_stopping)
+                m_wakeUp.wait(&m_mutex, CompactIntervalMs);
+        }
+
+        if (!m_stopping)
+            compact();
+    }
+}
@@ -0,0 +1,104 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_JOURNAL_H
+#define SNIPPY_JOURNAL_H
+
+#include "snippet.h"
+
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <atomic>
+
+class QThread;
+
+// Append-only log of snippet edits, so a save doesn't rewrite the whole .snip file.
+//
+// The first save of a snippet after a compaction records its full state, later ones only
+// the title, the tags and the changed middle of the body. A background thread folds the
+// journal into the .snip files every now and then, or sooner if it grows large, rotating
+// it first so saves aren't blocked meanwhile. Each generation of the journal replays on
+// its own, so after a crash both generations are replayed on startup and folded right away.
+// A file another process saved after the last edit journaled for it isn't overwritten.
+// Thread-safe. Used by DirectoryStorage, .snippack files are append-only already.
+
+class Journal
+{
+public:
+    explicit Journal(const QString &rootPath);
+    ~Journal();
+
+    bool append(const QString &absolutePath, const QString &title,
+                const QStringList &tags, const QString &contents);
+
+    // The latest journaled state, false if the file is up to date
+    bool pending(const QString &absolutePath, SnippetData &data, bool headerOnly);
+
+    // Before removing the file, or compaction would bring it back
+    void forget(const QString &absolutePath);
+
+    // Folds the journal into the .snip files, blocks while the compactor runs
+    void compact();
+
+private:
+    enum RecordType {
+        FullRecord = 1,
+        DeltaRecord,
+        RemoveRecord
+    };
+
+    struct State
+    {
+        QString title;
+        QStringList tags;
+        QString contents;
+
+        // Not journaled. Another process writes the file directly, whoever saved last wins.
+        qint64 fileModified = -1; // Of the file when this generation started journaling it
+        qint64 saved = 0; // When it was journaled last
+    };
+
+    void replay(const QString &journalPath);
+    void openJournal();
+    bool writeRecord(const QByteArray &payload);
+    QByteArray fullRecord(const QString &key, const State &state) const;
+    QHash<QString, State> writeSnippets(const QHash<QString, State> &states) const; // Returns the failed ones
+    QString key(const QString &absolutePath) const;
+    void runCompactor();
+
+    const QString m_rootPath;
+    const QString m_journalPath;
+    const QString m_rotatedPath; // The generation being compacted
+    QMutex m_mutex;
+    QMutex m_compactMutex; // Held while compacting, ordered before m_mutex
+    QWaitCondition m_wakeUp;
+    QFile m_file;
+    QHash<QString, State> m_pending; // By path relative to the root, in the current generation
+    QHash<QString, State> m_compacting; // Being written to the .snip files
+    QThread *m_thread = nullptr;
+    std::atomic<bool> m_stopping;
+};
+
+#endif
@@ -21,23 +21,56 @@
 */
 
 #include "kernel.h"
-#include "removeemptyfoldersproxymodel.h"
+#include "bodystore.h"
+#include "memorystats.h"
+#include "snippetstorage.h"
 #include <QDebug>
 
 Kernel::Kernel(QObject *parent)
     : QObject(parent)
     , m_model(new SnippetModel(this))
     , m_filterModel(new SnippetProxyModel(this))
-    //, m_cleanupProxy(new RemoveEmptyFoldersProxyModel(this))
     , m_externalEditor(QString::fromUtf8(qgetenv("SNIPPY_EDITOR")))
     , m_externalFileExplorer(QString::fromUtf8(qgetenv("SNIPPY_FILE_EXPLORER")))
 {
+    // A single proxy filters and hides empty folders, see SnippetProxyModel
     m_filterModel->setSourceModel(m_model);
-    /*m_cleanupProxy->setSourceModel(m_filterModel);
-    connect(m_filterModel, &SnippetProxyModel::filterTextChanged, [this] (const QString &text) {
-        // If there's no filter set then accept any empty folder
-        m_cleanupProxy->setAcceptsEmptyParents(text.isEmpty());
-    });*/
+
+    MemoryStats &stats = MemoryStats::instance();
+    stats.addSource(QStringLiteral("model"), this, [this] {
+        return m_model->itemsMemoryUsage();
+    });
+    stats.addSource(QStringLiteral("snippets"), this, [this] {
+        return m_model->snippetsMemoryUsage();
+    });
+    stats.addSource(QStringLiteral("bodies"), this, [] {
+        const BodyStore::Stats bodies = BodyStore::instance().stats();
+        MemoryUsage usage;
+        usage.objects = bodies.decoded + bodies.compressed;
+        usage.bytes = bodies.decodedBytes + bodies.compressedBytes;
+        return usage;
+    });
+    stats.addSource(QStringLiteral("tags"), this, [] {
+        return TagDictionary::instance().memoryUsage();
+    });
+    stats.addSource(QStringLiteral("index"), this, [this] {
+        return m_model->indexMemoryUsage();
+    });
+    stats.addSource(QStringLiteral("filter"), this, [this] {
+        return m_filterModel->memoryUsage();
+    });
+    stats.addSource(QStringLiteral("snapshot"), this, [this] {
+        return m_model->snapshot()->memoryUsage();
+    });
+}
+
+Kernel::~Kernel()
+{
+    // Snippets save what's pending when deleted, then the journals are folded into the .snip
+    // files. Otherwise those stay behind until the next start, for other programs too.
+    delete m_filterModel;
+    delete m_model;
+    SnippetStorage::closeAll();
 }
 
 SnippetProxyModel *Kernel::filterModel() const
@@ -52,7 +85,6 @@ SnippetModel *Kernel::model() const
 
 QAbstractProxyModel *Kernel::topLevelModel() const
 {
-    // return m_cleanupProxy;
     return m_filterModel;
 }
 
@@ -71,12 +103,12 @@ QString Kernel::externalFileExplorer() const
     return m_externalFileExplorer;
 }
 
-QModelIndex Kernel::mapToSource(QModelIndex idx)
+QModelIndex Kernel::mapToSource(QModelIndex idx) const
 {
     return m_filterModel->mapToSource(idx);
 }
 
-QModelIndex Kernel::mapFromSource(const QModelIndex &idx)
+QModelIndex Kernel::mapFromSource(const QModelIndex &idx) const
 {
     return m_filterModel->mapFromSource(idx);
 }
@@ -26,21 +26,20 @@
 #include "snippetmodel.h"
 #include "snippetproxymodel.h"
 
-// class RemoveEmptyFoldersProxyModel;
-
 class Kernel : public QObject
 {
     Q_OBJECT
 public:
     explicit Kernel(QObject *parent = nullptr);
+    ~Kernel() override;
     SnippetProxyModel *filterModel() const;
     SnippetModel *model() const;
     QAbstractProxyModel *topLevelModel() const; // The top-most model in the stack. Suitable for the tree view.
     QString externalEditor() const;
     QString externalFileExplorer() const;
 
-    QModelIndex mapToSource(QModelIndex); // From top-most -> bottom-most
-    QModelIndex mapFromSource(const QModelIndex &); // From bottom-most -> top-most
+    QModelIndex mapToSource(QModelIndex) const; // From top-most -> bottom-most
+    QModelIndex mapFromSource(const QModelIndex &) const; // From bottom-most -> top-most
 
 public Q_SLOTS:
     void load();
@@ -48,7 +47,6 @@ public Q_SLOTS:
 private:
     SnippetModel *const m_model;
     SnippetProxyModel *const m_filterModel;
-    // RemoveEmptyFoldersProxyModel *const m_cleanupProxy;
     const QString m_externalEditor;
     const QString m_externalFileExplorer;
 };
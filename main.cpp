@@ -21,19 +21,20 @@
 */
 
 #include "mainwindow.h"
+#include "singleinstance.h"
+#include "snippetmodel.h"
+#include "snippetstorage.h"
+#include "tracer.h"
 
 #include <QApplication>
+#include <QDir>
 #include <QStyleFactory>
 #include <QCommandLineParser>
+#include <QDebug>
 
-static QString getArg()
+static QString getArg(const QCommandLineParser &parser)
 {
-    QStringList args = qApp->arguments();
-    if (args.size() <= 1)
-        return QString();
-
-    args.removeAt(0);
-    return args.join(" ");
+    return parser.positionalArguments().join(" ");
 }
 
 int main(int argv, char **argc)
@@ -50,15 +51,48 @@ int main(int argv, char **argc)
     parser.addHelpOption();
     parser.addVersionOption();
     parser.addOption(QCommandLineOption("quit-after-loading", "Quit immediately after loading (for benchmark purposes)"));
+    parser.addOption(QCommandLineOption("new-instance", "Don't forward the filter to an already running instance"));
+    parser.addOption(QCommandLineOption("stats", "Print memory statistics after loading"));
+    parser.addOption(QCommandLineOption("trace", "Record a Chrome trace to <file>, same as SNIPPY_TRACE", "file"));
+    parser.addOption(QCommandLineOption("watchdog", "Log GUI stalls longer than <ms>, same as SNIPPY_WATCHDOG_MS", "ms"));
+    parser.addOption(QCommandLineOption("export", "Copy all snippets to <path>, a folder or a .snippack file, and quit", "path"));
     parser.process(app);
 
-    QString initialFilter = getArg();
+    if (parser.isSet("export")) {
+        const QStringList roots = SnippetModel::rootPaths();
+        if (roots.size() != 1) {
+            qWarning() << "--export needs SNIPPY_FOLDER to be a single root";
+            return 1;
+        }
+        const bool converted = SnippetStorage::convert(roots.first(), QDir(parser.value("export")).absolutePath());
+        SnippetStorage::closeAll();
+        return converted ? 0 : 1;
+    }
+
+    const QString traceFile = parser.isSet("trace") ? parser.value("trace") : QString::fromLocal8Bit(qgetenv("SNIPPY_TRACE"));
+    if (!traceFile.isEmpty())
+        Tracer::start(traceFile);
+
+    QString initialFilter = getArg(parser);
+
+    SingleInstance singleInstance;
+    const bool useSingleInstance = !parser.isSet("new-instance") && !parser.isSet("quit-after-loading");
+    if (useSingleInstance && singleInstance.forwardToRunningInstance(initialFilter))
+        return 0;
+
     MainWindow window(initialFilter);
     window.show();
 
-    if (parser.isSet("quit-after-loading")) {
-        QMetaObject::invokeMethod(&app, "quit", Qt::QueuedConnection);
+    const int stallThreshold = parser.isSet("watchdog") ? parser.value("watchdog").toInt() : qEnvironmentVariableIntValue("SNIPPY_WATCHDOG_MS");
+    if (stallThreshold > 0)
+        window.startWatchdog(stallThreshold);
+
+    if (useSingleInstance) {
+        singleInstance.listen();
+        QObject::connect(&singleInstance, &SingleInstance::activationRequested, &window, &MainWindow::activate);
     }
 
-    return app.exec();
+    const int result = app.exec();
+    Tracer::stop();
+    return result;
 }
@@ -21,7 +21,15 @@
 */
 
 #include "mainwindow.h"
+#include "bodystore.h"
+#include "flatresultsmodel.h"
+#include "memorystats.h"
+#include "snippetitemdelegate.h"
+#include "snippetstorage.h"
 #include "syntaxhighlighter.h"
+#include "tracer.h"
+#include "watchdog.h"
+#include "tagfacetmodel.h"
 
 #include <QTimer>
 #include <QItemSelection>
@@ -33,11 +41,45 @@
 #include <QDebug>
 #include <QWindow>
 #include <QSyntaxHighlighter>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QDockWidget>
+#include <QLabel>
+#include <QMenuBar>
+#include <QPlainTextEdit>
+#include <QTextBlock>
+#include <QVBoxLayout>
+#include <QListView>
+#include <QLocale>
+#include <QSortFilterProxyModel>
+#include <QStackedWidget>
+#include <QActionGroup>
 
 enum {
-    FilterUpdateTimeout = 400 // ms
+    FilterUpdateTimeout = 400, // ms
+    DefaultStallThresholdMs = 50
 };
 
+static MemoryUsage documentMemoryUsage(const QTextDocument *document)
+{
+    enum {
+        BlockBytes = 100 // Block, fragment and layout bookkeeping, roughly
+    };
+
+    MemoryUsage usage;
+    usage.bytes = document->characterCount() * qint64(sizeof(QChar));
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next()) {
+        usage.objects++;
+        usage.bytes += BlockBytes;
+        if (const QTextLayout *layout = block.layout()) // Where the highlighter's formats end up
+            usage.bytes += layout->formats().size() * qint64(sizeof(QTextLayout::FormatRange));
+    }
+
+    return usage;
+}
+
 static void runCommand(const QString &command)
 {
     auto proc = new QProcess();
@@ -62,13 +104,26 @@ MainWindow::MainWindow(const QString &initialFilter, QWidget *parent)
 
     m_splitter->setSizes({ 100, 1000 });
     m_treeView->setModel(m_kernel.topLevelModel());
+    m_treeView->setItemDelegate(new SnippetItemDelegate(m_treeView));
 
     connect(m_kernel.model(), &SnippetModel::loaded,
             [this](int num, const QString &path) { //
+                if (qApp->arguments().contains(QLatin1String("--stats")))
+                    qInfo().noquote() << MemoryStats::instance().report();
+
                 if (qApp->arguments().contains(QLatin1String("--quit-after-loading"))) {
                     qApp->quit();
                 }
-                statusBar()->showMessage(QStringLiteral("Loaded %1 snippets from %2").arg(num).arg(path));
+                statusBar()->showMessage(QStringLiteral("Loaded %1 snippets from %2 (%3 of bodies in memory)")
+                                             .arg(num)
+                                             .arg(path)
+                                             .arg(QLocale().formattedDataSize(BodyStore::instance().residentBytes())));
+
+                if (m_kernel.model()->isBrowseMode() && !m_filterLineEdit->text().isEmpty()) {
+                    // The index is complete now, it might know about more matches
+                    m_kernel.filterModel()->refresh();
+                    expandMatches();
+                }
             });
 
     /*connect(m_kernel.filterModel(), &SnippetProxyModel::countChanged,
@@ -77,7 +132,7 @@ MainWindow::MainWindow(const QString &initialFilter, QWidget *parent)
     });*/
 
     m_tagsLineEdit->setStyleSheet(QStringLiteral("QLineEdit { font-weight: bold; }"));
-    connect(m_tagsLineEdit, &QLineEdit::textChanged, this, &MainWindow::saveNewTags);
+    connect(m_tagsLineEdit, &TagsLineEdit::tagsEdited, this, &MainWindow::saveNewTags);
     connect(m_textEdit, &QPlainTextEdit::textChanged, this, &MainWindow::saveNewContents);
     connect(m_textEdit, &TextEdit::openExternallyRequested,
             this, &MainWindow::openCurrentSnippetInEditor);
@@ -106,15 +161,32 @@ MainWindow::MainWindow(const QString &initialFilter, QWidget *parent)
     connect(m_actionExpandAll, &QAction::triggered, m_treeView, &QTreeView::expandAll);
 
     m_filterLineEdit->setFocus();
-    connect(m_filterLineEdit, &QLineEdit::textChanged, this, &MainWindow::scheduleFilter);
-    m_filterLineEdit->setText(initialFilter);
     m_scheduleFilterTimer.setSingleShot(true);
     connect(&m_scheduleFilterTimer, &QTimer::timeout, this, &MainWindow::updateFilter);
+    connect(m_filterLineEdit, &QLineEdit::textChanged, this, &MainWindow::scheduleFilter);
     connect(m_deepSearchCB, &QCheckBox::toggled, this, &MainWindow::updateFilter);
 
+    // Snippets arrive in chunks while loading, the initial filter is applied to them as they come
+    connect(m_kernel.topLevelModel(), &QAbstractItemModel::rowsInserted, this, &MainWindow::onRowsInserted);
+    connect(m_kernel.model(), &QAbstractItemModel::modelAboutToBeReset, this, [this] {
+        setSnippet(nullptr);
+    });
+
+    if (!initialFilter.isEmpty()) {
+        m_filterLineEdit->setText(initialFilter);
+        m_scheduleFilterTimer.stop();
+        updateFilter();
+    }
+
     connect(m_kernel.filterModel(), &SnippetProxyModel::filterHasErrorChanged,
             this, &MainWindow::updateFilterBackground);
 
+    setupTagsDock();
+    setupFlatResults();
+    setupSortMenu();
+    m_watchdog = new Watchdog(this);
+    setupDebugMenu();
+
     create();
 
     QWindow *window = windowHandle();
@@ -130,17 +202,22 @@ MainWindow::MainWindow(const QString &initialFilter, QWidget *parent)
 
 void MainWindow::setSnippet(Snippet *snippet)
 {
+    SNIPPY_TRACE_ARGS("MainWindow::setSnippet", snippet ? snippet->relativePath() : QString());
     // if (m_snippet == snippet)
     // return;
 
+    m_tagsLineEdit->commit(); // Still for the previous snippet
+
     m_snippet = snippet;
+    m_highlighter->reset();
 
     if (snippet) {
         m_textEdit->document()->setPlainText(snippet->contents());
-        m_tagsLineEdit->setText(snippet->tagsString());
+        m_highlighter->setSpans(m_kernel.filterModel()->bodyMatchSpans(snippet));
+        m_tagsLineEdit->setCommittedText(snippet->tagsString());
     } else {
         m_textEdit->document()->setPlainText(QString());
-        m_tagsLineEdit->setText(QString());
+        m_tagsLineEdit->setCommittedText(QString());
     }
 
     m_textEdit->setEnabled(snippet);
@@ -148,8 +225,24 @@ void MainWindow::setSnippet(Snippet *snippet)
     m_delAction->setEnabled(snippet);
 }
 
+void MainWindow::activate(const QString &filter)
+{
+    m_filterLineEdit->setText(filter);
+    m_scheduleFilterTimer.stop(); // No debouncing, the user is waiting for results
+    updateFilter();
+
+    setWindowState(windowState() & ~Qt::WindowMinimized);
+    show();
+    raise();
+    activateWindow();
+}
+
 void MainWindow::onSelectionChanged(const QItemSelection &selection, const QItemSelection & /*deselection*/)
 {
+    // The hidden view's selection follows its model around, it's not the user's
+    if (sender() && sender() != currentView()->selectionModel())
+        return;
+
     const QModelIndexList indexes = selection.indexes();
     if (indexes.isEmpty()) {
         setSnippet(nullptr);
@@ -182,6 +275,7 @@ void MainWindow::createFolder()
 {
     const QString &name = QInputDialog::getText(this, "Snippy", "Enter folder name");
     if (!name.isEmpty()) {
+        m_flatResultsAction->setChecked(false); // Shown where it lands
         QModelIndex selectedProxyIndex = selectedIndex();
         QModelIndex selectedIndex = m_kernel.mapToSource(selectedProxyIndex);
         QStandardItem *newItem = m_kernel.model()->createFolder(name, selectedIndex);
@@ -199,10 +293,12 @@ void MainWindow::createFolder()
 
 void MainWindow::createSnippet()
 {
-    QModelIndexList indexes = m_treeView->selectionModel()->selectedIndexes();
+    // Named in place in the tree
+    const QModelIndex index = selectedIndex();
+    m_flatResultsAction->setChecked(false);
+
     QModelIndex parentIndex;
-    if (!indexes.isEmpty()) {
-        QModelIndex index = indexes.at(0);
+    if (index.isValid()) {
         if (index.data(SnippetModel::IsFolderRole).toBool()) {
             parentIndex = index;
         } else {
@@ -224,6 +320,7 @@ void MainWindow::createSnippet()
 void MainWindow::deleteSnippet()
 {
     QModelIndex proxyIndex = selectedIndex();
+    setSnippet(nullptr); // The model deletes it
     m_kernel.model()->removeSnippet(m_kernel.mapToSource(proxyIndex));
 }
 
@@ -232,37 +329,327 @@ void MainWindow::scheduleFilter()
     m_scheduleFilterTimer.start(FilterUpdateTimeout);
 }
 
+void MainWindow::setupDebugMenu()
+{
+    MemoryStats::instance().addSource(QStringLiteral("editor"), this, [this] {
+        return documentMemoryUsage(m_textEdit->document());
+    });
+
+    m_debugMenu = menuBar()->addMenu(tr("&Debug"));
+    QAction *action = m_debugMenu->addAction(tr("Memory Statistics..."));
+    connect(action, &QAction::triggered, this, [this] {
+        showReport(tr("Memory Statistics"), [] {
+            return MemoryStats::instance().report();
+        });
+    });
+
+    // Only the cheap numbers, the full report walks the whole model
+    m_memoryLabel = new QLabel(this);
+    m_memoryLabel->hide();
+    statusBar()->addPermanentWidget(m_memoryLabel);
+    auto timer = new QTimer(m_memoryLabel);
+    connect(timer, &QTimer::timeout, this, &MainWindow::updateMemoryLabel);
+
+    action = m_debugMenu->addAction(tr("Memory in Status Bar"));
+    action->setCheckable(true);
+    connect(action, &QAction::toggled, this, [this, timer](bool show) {
+        m_memoryLabel->setVisible(show);
+        if (show) {
+            updateMemoryLabel();
+            timer->start(2000);
+        } else {
+            timer->stop();
+        }
+    });
+
+    m_debugMenu->addSeparator();
+    m_watchdogAction = m_debugMenu->addAction(tr("Stall Watchdog"));
+    m_watchdogAction->setCheckable(true);
+    connect(m_watchdogAction, &QAction::toggled, this, [this](bool on) {
+        if (on)
+            m_watchdog->start(DefaultStallThresholdMs);
+        else
+            m_watchdog->stop();
+    });
+
+    action = m_debugMenu->addAction(tr("Event Loop Latency..."));
+    connect(action, &QAction::triggered, this, [this] {
+        showReport(tr("Event Loop Latency"), [this] {
+            return m_watchdog->report();
+        });
+    });
+
+    m_debugMenu->addSeparator();
+    action = m_debugMenu->addAction(tr("Explain Filter..."));
+    connect(action, &QAction::triggered, this, [this] {
+        auto filterModel = m_kernel.filterModel();
+        filterModel->setExplaining(true);
+        QDialog *dialog = showReport(tr("Filter Plan"), [filterModel] {
+            return filterModel->explainFilter();
+        });
+        connect(dialog, &QObject::destroyed, filterModel, [filterModel] {
+            filterModel->setExplaining(false);
+        });
+    });
+}
+
+void MainWindow::startWatchdog(int thresholdMs)
+{
+    m_watchdog->start(thresholdMs);
+    m_watchdogAction->setChecked(true);
+}
+
+QDialog *MainWindow::showReport(const QString &title, const std::function<QString()> &report)
+{
+    auto dialog = new QDialog(this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->setWindowTitle(title);
+    auto text = new QPlainTextEdit(dialog);
+    text->setReadOnly(true);
+    auto layout = new QVBoxLayout(dialog);
+    layout->addWidget(text);
+
+    // On demand, some reports walk the whole model and every snapshot entry
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Close, dialog);
+    QPushButton *refreshButton = buttons->addButton(tr("Refresh"), QDialogButtonBox::ActionRole);
+    layout->addWidget(buttons);
+    connect(buttons, &QDialogButtonBox::rejected, dialog, &QDialog::close);
+
+    auto refresh = [text, report] {
+        const int scrollPosition = text->verticalScrollBar()->value();
+        text->setPlainText(report());
+        text->verticalScrollBar()->setValue(scrollPosition);
+    };
+    connect(refreshButton, &QPushButton::clicked, text, refresh);
+    refresh();
+
+    dialog->resize(500, 300);
+    dialog->show();
+    return dialog;
+}
+
+void MainWindow::updateMemoryLabel()
+{
+    const QLocale locale;
+    QString text = tr("Bodies: %1").arg(locale.formattedDataSize(BodyStore::instance().residentBytes()));
+    const qint64 rss = MemoryStats::residentSetSize();
+    if (rss >= 0)
+        text += tr(", RSS: %1").arg(locale.formattedDataSize(rss));
+
+    m_memoryLabel->setText(text);
+}
+
 void MainWindow::updateFilter()
 {
-    const QString text = m_filterLineEdit->text();
-    const bool hasText = !text.isEmpty();
+    SNIPPY_TRACE_ARGS("MainWindow::updateFilter", m_filterLineEdit->text());
     auto filterModel = m_kernel.filterModel();
-    filterModel->setFilterText(text);
+    filterModel->setFilterText(m_filterLineEdit->text());
     filterModel->setIsDeepSearch(m_deepSearchCB->isChecked());
-    if (hasText)
+    showFilterResults();
+
+    m_highlighter->setSpans(filterModel->bodyMatchSpans(m_snippet));
+}
+
+void MainWindow::showFilterResults()
+{
+    if (!m_kernel.filterModel()->isFiltering())
+        return;
+
+    expandMatches();
+    selectFirstSnippet(QModelIndex(), 0, m_kernel.topLevelModel()->rowCount() - 1);
+}
+
+void MainWindow::setupFlatResults()
+{
+    m_flatModel = new FlatResultsModel(m_kernel.filterModel(), this);
+    m_flatView = new QListView();
+    m_flatView->setModel(m_flatModel);
+    m_flatView->setUniformItemSizes(true); // Only the first row is measured
+    m_flatView->setLayoutMode(QListView::Batched);
+    m_flatView->setMinimumSize(m_treeView->minimumSize());
+
+    auto stack = new QStackedWidget();
+    m_splitter->replaceWidget(m_splitter->indexOf(m_treeView), stack);
+    stack->addWidget(m_treeView);
+    stack->addWidget(m_flatView);
+    stack->setCurrentWidget(m_treeView);
+    m_treeView->show();
+
+    connect(m_flatView->selectionModel(), &QItemSelectionModel::selectionChanged, this, &MainWindow::onSelectionChanged);
+    auto selectFirst = [this] {
+        if (isFlatResults())
+            selectFirstSnippet(QModelIndex(), 0, 0);
+    };
+    connect(m_flatModel, &QAbstractItemModel::rowsInserted, this, selectFirst);
+    connect(m_flatModel, &QAbstractItemModel::modelReset, this, selectFirst);
+
+    m_flatResultsAction = menuTools->addAction(tr("Flat Results"));
+    m_flatResultsAction->setCheckable(true);
+    connect(m_flatResultsAction, &QAction::toggled, this, &MainWindow::setFlatResults);
+}
+
+void MainWindow::setupSortMenu()
+{
+    QMenu *menu = menuTools->addMenu(tr("Sort By"));
+    auto group = new QActionGroup(menu);
+    auto addOrder = [this, menu, group](const QString &text, SnippetProxyModel::SortOrder order) {
+        QAction *action = menu->addAction(text);
+        action->setCheckable(true);
+        action->setChecked(m_kernel.filterModel()->sortOrder() == order);
+        group->addAction(action);
+        connect(action, &QAction::triggered, this, [this, order] {
+            m_kernel.filterModel()->setSortOrder(order);
+        });
+    };
+
+    addOrder(tr("Folder Order"), SnippetProxyModel::FolderOrder);
+    addOrder(tr("Title"), SnippetProxyModel::TitleOrder);
+    addOrder(tr("Last Modified"), SnippetProxyModel::ModifiedOrder);
+    addOrder(tr("Size"), SnippetProxyModel::SizeOrder);
+    addOrder(tr("Match Score"), SnippetProxyModel::ScoreOrder);
+}
+
+void MainWindow::setFlatResults(bool flat)
+{
+    if (flat == isFlatResults())
+        return;
+
+    SNIPPY_TRACE_ARGS("MainWindow::setFlatResults", flat ? QStringLiteral("flat") : QStringLiteral("tree"));
+    const QModelIndex selected = m_kernel.mapToSource(selectedIndex()); // Kept selected in the other view
+
+    m_flatModel->setActive(flat);
+    auto stack = qobject_cast<QStackedWidget *>(m_treeView->parentWidget());
+    stack->setCurrentWidget(currentView());
+
+    if (!flat)
+        expandMatches(); // Not kept up while the list was shown
+
+    const QModelIndex index = flat ? m_flatModel->mapFromSource(selected) : m_kernel.mapFromSource(selected);
+    if (index.isValid()) {
+        currentView()->selectionModel()->select(index, QItemSelectionModel::ClearAndSelect);
+        currentView()->scrollTo(index);
+    } else {
+        selectFirstSnippet(QModelIndex(), 0, m_kernel.topLevelModel()->rowCount() - 1);
+    }
+}
+
+bool MainWindow::isFlatResults() const
+{
+    return m_flatModel && m_flatModel->isActive();
+}
+
+QAbstractItemView *MainWindow::currentView() const
+{
+    if (isFlatResults())
+        return m_flatView;
+
+    return m_treeView;
+}
+
+void MainWindow::setupTagsDock()
+{
+    auto dock = new QDockWidget(tr("Tags"), this);
+    dock->setObjectName(QStringLiteral("tagsDock"));
+
+    auto view = new QListView(dock);
+    auto facetModel = new TagFacetModel(m_kernel.filterModel(), view);
+    auto sortedModel = new QSortFilterProxyModel(view);
+    sortedModel->setSourceModel(facetModel);
+    sortedModel->setSortRole(TagFacetModel::TagRole);
+    sortedModel->setSortCaseSensitivity(Qt::CaseInsensitive);
+    sortedModel->sort(0);
+    view->setModel(sortedModel);
+    view->setUniformItemSizes(true);
+    connect(view, &QListView::clicked, facetModel, [facetModel, sortedModel](const QModelIndex &index) {
+        facetModel->toggle(sortedModel->mapToSource(index));
+    });
+
+    connect(m_kernel.filterModel(), &SnippetProxyModel::requiredTagsChanged, this, &MainWindow::showFilterResults);
+
+    dock->setWidget(view);
+    addDockWidget(Qt::LeftDockWidgetArea, dock);
+    dock->hide();
+    menuTools->addAction(dock->toggleViewAction());
+}
+
+void MainWindow::expandMatches()
+{
+    SNIPPY_TRACE("MainWindow::expandMatches");
+    if (m_kernel.model()->isBrowseMode())
+        fetchMatchingFolders(QModelIndex());
+
+    // The list has no folders, and expanding thousands of them is what it's there to avoid
+    if (!isFlatResults())
         m_treeView->expandAll();
+}
 
-    if (hasText && !selectedIndex().isValid()) {
-        QModelIndex index = firstSnippet(QModelIndex());
+void MainWindow::fetchMatchingFolders(const QModelIndex &parent)
+{
+    // Only folders that passed the filter (through the index) get read.
+    // Persistent, fetching inserts rows that can shift what's still pending.
+    auto model = m_kernel.topLevelModel();
+    QVector<QPersistentModelIndex> pending = { parent };
+    while (!pending.isEmpty()) {
+        const QModelIndex folder = pending.takeLast();
+        if (folder != parent && !folder.isValid())
+            continue; // Went away meanwhile
+
+        if (model->canFetchMore(folder))
+            model->fetchMore(folder);
+
+        for (int row = 0, count = model->rowCount(folder); row < count; ++row) {
+            const QModelIndex index = model->index(row, 0, folder);
+            if (index.data(SnippetModel::IsFolderRole).toBool())
+                pending.append(index);
+        }
+    }
+}
+
+void MainWindow::onRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    if (!m_kernel.filterModel()->isFiltering() || isFlatResults())
+        return;
+
+    auto model = m_kernel.topLevelModel();
+    for (int row = first; row <= last; ++row)
+        m_treeView->expandRecursively(model->index(row, 0, parent));
+
+    selectFirstSnippet(parent, first, last);
+}
+
+void MainWindow::selectFirstSnippet(const QModelIndex &parent, int first, int last)
+{
+    if (selectedIndex().isValid())
+        return;
+
+    if (isFlatResults()) {
+        if (m_flatModel->rowCount() > 0)
+            m_flatView->selectionModel()->select(m_flatModel->index(0), QItemSelectionModel::Select);
+        return;
+    }
+
+    auto model = m_kernel.topLevelModel();
+    for (int row = first; row <= last; ++row) {
+        QModelIndex index = firstSnippet(model->index(row, 0, parent));
         if (index.isValid()) {
             m_treeView->selectionModel()->select(index, QItemSelectionModel::Select);
+            return;
         }
     }
-
-    m_highlighter->setTokens(m_kernel.filterModel()->searchTokens());
 }
 
 QModelIndex MainWindow::firstSnippet(const QModelIndex &index) const
 {
-    if (index.isValid() && !index.data(SnippetModel::IsFolderRole).toBool())
-        return index;
-
+    // Depth-first without recursion, deep trees would otherwise overflow the stack
     auto model = m_kernel.topLevelModel();
-    const int count = model->rowCount(index);
-    for (int row = 0; row < count; ++row) {
-        QModelIndex candidate = firstSnippet(model->index(row, 0, index));
-        if (candidate.isValid())
-            return candidate;
+    QVector<QModelIndex> pending = { index };
+    while (!pending.isEmpty()) {
+        const QModelIndex current = pending.takeLast();
+        if (current.isValid() && !current.data(SnippetModel::IsFolderRole).toBool())
+            return current;
+
+        for (int row = model->rowCount(current) - 1; row >= 0; --row) // Reversed, so row 0 is next
+            pending.append(model->index(row, 0, current));
     }
 
     return {};
@@ -284,6 +671,19 @@ void MainWindow::openCurrentSnippetInEditor()
     }
 
     const QString filename = m_snippet->absolutePath();
+    SnippetStorage *storage = SnippetStorage::forPath(filename);
+    if (SnippetStorage::isPackedPath(storage->root())) {
+        // The path is virtual, whatever the editor wrote there would be ignored
+        qWarning() << Q_FUNC_INFO << "Can't open a packed snippet in an external editor" << filename;
+        statusBar()->showMessage(tr("Snippets in a .snippack can't be opened in an external editor"));
+        return;
+    }
+
+    // Compressed bodies would show up as binary, and saving from the editor would destroy them
+    if (!storage->makeEditable(filename)) {
+        statusBar()->showMessage(tr("Failed to prepare %1 for the external editor").arg(filename));
+        return;
+    }
 
     QString fullCommand = editorCommand;
     if (editorCommand.contains(QLatin1String("%1"))) {
@@ -319,7 +719,7 @@ void MainWindow::openFileExplorer(QString path)
 
 void MainWindow::openDataFolder()
 {
-    openFileExplorer(m_kernel.model()->snippetDataFolder());
+    openFileExplorer(SnippetModel::rootPaths().first());
 }
 
 void MainWindow::updateFilterBackground(bool isError)
@@ -332,6 +732,12 @@ void MainWindow::updateFilterBackground(bool isError)
 
 QModelIndex MainWindow::selectedIndex() const
 {
-    const QModelIndexList indexes = m_treeView->selectionModel()->selectedIndexes();
-    return indexes.isEmpty() ? QModelIndex() : indexes.first();
+    const QModelIndexList indexes = currentView()->selectionModel()->selectedIndexes();
+    if (indexes.isEmpty())
+        return QModelIndex();
+
+    if (isFlatResults())
+        return m_kernel.mapFromSource(m_flatModel->mapToSource(indexes.first()));
+
+    return indexes.first();
 }
@@ -29,17 +29,33 @@
 
 #include <QMainWindow>
 
+#include <functional>
+
+class FlatResultsModel;
 class SyntaxHighlighter;
+class QAbstractItemView;
 class QItemSelection;
 class QAction;
+class QListView;
 class QTimer;
+class QLabel;
+class QMenu;
+class QDialog;
+class Watchdog;
 
 class MainWindow : public QMainWindow, private Ui::MainWindow
 {
     Q_OBJECT
+    friend class LatencyHarness; // Drives the widgets, see benchmarks/latencyharness.cpp
+    friend class CoreBenchmark; // Waits for the window's own load
 public:
     explicit MainWindow(const QString &initialFilter, QWidget *parent = nullptr);
     void setSnippet(Snippet *);
+    void startWatchdog(int thresholdMs);
+
+public Q_SLOTS:
+    // Called when another snippy process was launched, it forwarded us its filter
+    void activate(const QString &filter);
 
 private Q_SLOTS:
     void onSelectionChanged(const QItemSelection &selection, const QItemSelection &deselection);
@@ -50,14 +66,28 @@ private Q_SLOTS:
     void deleteSnippet();
     void scheduleFilter();
     void updateFilter();
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
 
 private:
     QModelIndex firstSnippet(const QModelIndex &) const;
+    void selectFirstSnippet(const QModelIndex &parent, int first, int last);
+    void expandMatches();
+    void showFilterResults();
+    void setupTagsDock();
+    void setupFlatResults();
+    void setupSortMenu();
+    void setFlatResults(bool);
+    bool isFlatResults() const;
+    QAbstractItemView *currentView() const;
+    void setupDebugMenu();
+    QDialog *showReport(const QString &title, const std::function<QString()> &report); // Refreshed on demand
+    void updateMemoryLabel();
+    void fetchMatchingFolders(const QModelIndex &parent);
     void openCurrentSnippetInEditor();
     void openFileExplorer(QString path);
     void openDataFolder();
     void updateFilterBackground(bool isError);
-    QModelIndex selectedIndex() const;
+    QModelIndex selectedIndex() const; // In topLevelModel(), also when the flat results are shown
     Snippet *m_snippet;
     SyntaxHighlighter *m_highlighter = nullptr;
     Kernel m_kernel;
@@ -65,6 +95,13 @@ private:
     QAction *m_newAction;
     QAction *m_delAction;
     QTimer m_scheduleFilterTimer;
+    QMenu *m_debugMenu = nullptr;
+    QLabel *m_memoryLabel = nullptr;
+    Watchdog *m_watchdog = nullptr;
+    QAction *m_watchdogAction = nullptr;
+    QListView *m_flatView = nullptr;
+    FlatResultsModel *m_flatModel = nullptr;
+    QAction *m_flatResultsAction = nullptr;
 };
 
 #endif
@@ -0,0 +1,103 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "memorystats.h"
+
+#include <QLocale>
+#include <QStringList>
+
+#ifdef Q_OS_LINUX
+#include <QFile>
+#include <unistd.h>
+#endif
+
+MemoryStats &MemoryStats::instance()
+{
+    static MemoryStats stats;
+    return stats;
+}
+
+void MemoryStats::addSource(const QString &name, const QObject *context, const Source &source)
+{
+    m_sources.append({ name, context, source });
+}
+
+QVector<QPair<QString, MemoryUsage>> MemoryStats::usages() const
+{
+    QVector<QPair<QString, MemoryUsage>> result;
+    for (const Entry &entry : m_sources) {
+        if (entry.context)
+            result.append({ entry.name, entry.source() });
+    }
+
+    return result;
+}
+
+QString MemoryStats::report() const
+{
+    const QLocale locale;
+    QStringList lines;
+    lines << QStringLiteral("Memory (estimated):");
+
+    MemoryUsage total;
+    for (const auto &usage : usages()) {
+        lines << QStringLiteral("  %1 %2 objects %3")
+                     .arg(usage.first, -10)
+                     .arg(usage.second.objects, 9)
+                     .arg(locale.formattedDataSize(usage.second.bytes), 10);
+        total.objects += usage.second.objects;
+        total.bytes += usage.second.bytes;
+    }
+
+    lines << QStringLiteral("  %1 %2 objects %3").arg(QStringLiteral("total"), -10).arg(total.objects, 9).arg(locale.formattedDataSize(total.bytes), 10);
+
+    const qint64 rss = residentSetSize();
+    if (rss >= 0)
+        lines << QStringLiteral("  %1 %2").arg(QStringLiteral("process RSS"), -28).arg(locale.formattedDataSize(rss), 10);
+
+    return lines.join(QLatin1Char('\n'));
+}
+
+/*static*/
+qint64 MemoryStats::residentSetSize()
+{
+#ifdef Q_OS_LINUX
+    QFile file(QStringLiteral("/proc/self/statm"));
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+
+    const QList<QByteArray> fields = file.readAll().split(' ');
+    if (fields.size() < 2)
+        return -1;
+
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+/*static*/
+qint64 MemoryStats::stringBytes(const QString &str)
+{
+    // Null strings share a static header, others have their own plus the UTF-16 payload
+    return str.isNull() ? 0 : 16 + str.capacity() * qint64(sizeof(QChar));
+}
@@ -0,0 +1,72 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_MEMORY_STATS_H
+#define SNIPPY_MEMORY_STATS_H
+
+#include <QPair>
+#include <QPointer>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+struct MemoryUsage
+{
+    int objects = 0;
+    qint64 bytes = 0;
+};
+
+// Registry of per-subsystem memory usage, printed by --stats and shown by the Debug menu.
+// Each subsystem reports itself when asked, nothing is tracked in the hot paths.
+// The numbers are estimates: payloads are counted exactly, Qt's private overhead isn't.
+
+class MemoryStats
+{
+public:
+    using Source = std::function<MemoryUsage()>;
+
+    static MemoryStats &instance();
+
+    // The source is forgotten once context is destroyed
+    void addSource(const QString &name, const QObject *context, const Source &source);
+
+    QVector<QPair<QString, MemoryUsage>> usages() const;
+    QString report() const;
+
+    static qint64 residentSetSize(); // Of the whole process, -1 if unknown
+    static qint64 stringBytes(const QString &);
+
+private:
+    MemoryStats() = default;
+
+    struct Entry
+    {
+        QString name;
+        QPointer<const QObject> context;
+        Source source;
+    };
+
+    QVector<Entry> m_sources;
+};
+
+#endif
@@ -0,0 +1,487 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "packedstorage.h"
+#include "tracer.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+static const char s_magic[] = "SNIPPACK";
+
+enum {
+    MagicSize = 8,
+    Version = 1,
+    HeaderSize = MagicSize + 4,
+    RecordHeaderSize = 12, // type, key size and payload size, little-endian
+    CompactMinGarbageBytes = 4 * 1024 * 1024
+};
+
+static QByteArray fileHeader()
+{
+    QByteArray header(s_magic, MagicSize);
+    header.resize(HeaderSize);
+    qToLittleEndian<quint32>(Version, header.data() + MagicSize);
+    return header;
+}
+
+static QByteArray record(int type, const QByteArray &key, const QByteArray &payload)
+{
+    QByteArray result(RecordHeaderSize, Qt::Uninitialized);
+    qToLittleEndian<quint32>(quint32(type), result.data());
+    qToLittleEndian<quint32>(quint32(key.size()), result.data() + 4);
+    qToLittleEndian<quint32>(quint32(payload.size()), result.data() + 8);
+    return result + key + payload;
+}
+
+PackedStorage::PackedStorage(const QString &packPath)
+    : SnippetStorage(packPath)
+    , m_lock(packPath + QStringLiteral(".lock"))
+{
+    m_lock.setStaleLockTime(0); // Only stale if the holder died
+    ownsPack();
+    addFolder(QString());
+    load();
+
+    const qint64 garbage = m_file.size() - HeaderSize - m_liveBytes;
+    if (m_writable && garbage > m_liveBytes && garbage > CompactMinGarbageBytes)
+        compact();
+}
+
+PackedStorage::~PackedStorage()
+{
+    unload();
+}
+
+bool PackedStorage::list(const QString &folderPath, QStringList &snippetNames, QStringList &subFolders)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_folders.constFind(key(folderPath));
+    if (it == m_folders.cend())
+        return false;
+
+    // Same order as QDir's
+    snippetNames = QStringList(it->snippets.values());
+    snippetNames.sort(Qt::CaseInsensitive);
+    subFolders = QStringList(it->subFolders.values());
+    subFolders.sort(Qt::CaseInsensitive);
+    return true;
+}
+
+bool PackedStorage::read(const QString &absolutePath, SnippetData &data, bool headerOnly)
+{
+    data.absolutePath = absolutePath;
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.constFind(key(absolutePath));
+    if (it == m_entries.cend()) {
+        qWarning() << Q_FUNC_INFO << "No such snippet" << absolutePath;
+        return false;
+    }
+
+    parse(bytesAt(it->offset, it->size), data, headerOnly);
+    data.size = it->size;
+    data.modified = m_file.fileTime(QFileDevice::FileModificationTime).toMSecsSinceEpoch(); // Records have no times
+    if (data.title.isEmpty())
+        qWarning() << Q_FUNC_INFO << "Invalid snippet" << absolutePath;
+
+    return true;
+}
+
+bool PackedStorage::write(const QString &absolutePath, const QString &title,
+                          const QStringList &tags, const QString &contents)
+{
+    QMutexLocker locker(&m_mutex);
+    reloadIfReplaced();
+    const QString key = this->key(absolutePath);
+    if (key.isEmpty() || m_folders.contains(key))
+        return false;
+
+    return append(PutRecord, key, serialize(title, tags, contents));
+}
+
+bool PackedStorage::remove(const QString &absolutePath)
+{
+    QMutexLocker locker(&m_mutex);
+    reloadIfReplaced();
+    const QString key = this->key(absolutePath);
+    if (key.isEmpty() || (!m_entries.contains(key) && !m_folders.contains(key)))
+        return false;
+
+    return append(RemoveRecord, key);
+}
+
+bool PackedStorage::exists(const QString &absolutePath)
+{
+    QMutexLocker locker(&m_mutex);
+    const QString key = this->key(absolutePath);
+    return m_entries.contains(key) || m_folders.contains(key);
+}
+
+bool PackedStorage::makeFolder(const QString &absolutePath)
+{
+    QMutexLocker locker(&m_mutex);
+    reloadIfReplaced();
+    const QString key = this->key(absolutePath);
+    if (m_folders.contains(key))
+        return true;
+
+    return !m_entries.contains(key) && append(FolderRecord, key);
+}
+
+bool PackedStorage::renameFolder(const QString &absolutePath, const QString &newAbsolutePath)
+{
+    QMutexLocker locker(&m_mutex);
+    reloadIfReplaced();
+    const QString from = key(absolutePath);
+    const QString to = key(newAbsolutePath);
+    if (from.isEmpty() || to.isEmpty() || !m_folders.contains(from) || m_folders.contains(to) || m_entries.contains(to))
+        return false;
+
+    const QString prefix = from + QLatin1Char('/');
+    QStringList folders;
+    foreach (const QString &folder, m_folders.keys()) {
+        if (folder == from || folder.startsWith(prefix))
+            folders << folder;
+    }
+    std::sort(folders.begin(), folders.end()); // Parents first
+
+    QStringList snippets;
+    foreach (const QString &snippet, m_entries.keys()) {
+        if (snippet.startsWith(prefix))
+            snippets << snippet;
+    }
+
+    // Copy first, so failing half-way leaves the old folder complete
+    foreach (const QString &folder, folders) {
+        if (!append(FolderRecord, to + folder.mid(from.size())))
+            return false;
+    }
+
+    foreach (const QString &snippet, snippets) {
+        const Entry entry = m_entries.value(snippet);
+        if (!append(PutRecord, to + snippet.mid(from.size()), bytesAt(entry.offset, entry.size)))
+            return false;
+    }
+
+    return append(RemoveRecord, from);
+}
+
+bool PackedStorage::makeEditable(const QString &)
+{
+    return false;
+}
+
+bool PackedStorage::compact()
+{
+    SNIPPY_TRACE_ARGS("PackedStorage::compact", root());
+    QMutexLocker locker(&m_mutex);
+    if (!m_writable)
+        return false;
+
+    if (!ownsPack()) {
+        qWarning() << Q_FUNC_INFO << root() << "is open in another process, not compacting";
+        return false;
+    }
+
+    reloadIfReplaced();
+
+    QSaveFile file(root());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << Q_FUNC_INFO << "Failed to open" << root() << file.errorString();
+        return false;
+    }
+
+    // Empty folders would be lost otherwise, parents first
+    QStringList folders = m_folders.keys();
+    std::sort(folders.begin(), folders.end());
+    QStringList snippets = m_entries.keys();
+    std::sort(snippets.begin(), snippets.end());
+
+    file.write(fileHeader());
+    foreach (const QString &folder, folders) {
+        if (!folder.isEmpty())
+            file.write(record(FolderRecord, folder.toUtf8(), {}));
+    }
+
+    foreach (const QString &snippet, snippets) {
+        const Entry entry = m_entries.value(snippet);
+        file.write(record(PutRecord, snippet.toUtf8(), bytesAt(entry.offset, entry.size)));
+    }
+
+    // Windows can't replace a file that's open, let alone mapped
+    unload();
+    if (!file.commit()) {
+        qWarning() << Q_FUNC_INFO << "Failed to write" << root() << file.errorString();
+        load(); // The old pack is still there
+        return false;
+    }
+
+    return load();
+}
+
+bool PackedStorage::load()
+{
+    SNIPPY_TRACE_ARGS("PackedStorage::load", root());
+    m_file.setFileName(root());
+    m_writable = m_file.open(QIODevice::ReadWrite);
+    if (!m_writable && !m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << Q_FUNC_INFO << "Failed to open" << root() << m_file.errorString();
+        return false;
+    }
+
+    if (m_file.size() == 0 && m_writable) {
+        m_file.write(fileHeader());
+        m_file.flush();
+    }
+
+    if (bytesAt(0, HeaderSize) != fileHeader()) {
+        qWarning() << Q_FUNC_INFO << root() << "is not a snippet pack, or from a newer version";
+        m_writable = false;
+        return false;
+    }
+
+    // Just the record headers and keys, the payloads are only touched when read
+    const qint64 size = m_file.size();
+    qint64 pos = HeaderSize;
+    while (pos + RecordHeaderSize <= size) {
+        const QByteArray header = bytesAt(pos, RecordHeaderSize);
+        const quint32 type = qFromLittleEndian<quint32>(header.constData());
+        const qint64 keyBytes = qFromLittleEndian<quint32>(header.constData() + 4);
+        const qint64 payloadBytes = qFromLittleEndian<quint32>(header.constData() + 8);
+        if (type < PutRecord || type > FolderRecord) {
+            qWarning() << Q_FUNC_INFO << "Unknown record at" << pos << "in" << root() << ", opening read-only";
+            m_writable = false;
+            return false;
+        }
+
+        const qint64 end = pos + RecordHeaderSize + keyBytes + payloadBytes;
+        if (end > size)
+            break;
+
+        const QString key = QString::fromUtf8(bytesAt(pos + RecordHeaderSize, keyBytes));
+        apply(RecordType(type), key, int(keyBytes), pos + RecordHeaderSize + keyBytes, int(payloadBytes));
+        pos = end;
+    }
+
+    if (pos != size) {
+        // A crash while appending, drop the partial record so the next one isn't appended after it
+        qWarning() << Q_FUNC_INFO << "Ignoring a torn record at the end of" << root();
+        if (m_writable) {
+            if (m_map)
+                m_file.unmap(m_map);
+            m_map = nullptr;
+            m_mapSize = 0;
+            m_file.resize(pos);
+        }
+    }
+
+    return true;
+}
+
+bool PackedStorage::ownsPack()
+{
+    return m_lock.isLocked() || m_lock.tryLock(0);
+}
+
+void PackedStorage::reloadIfReplaced()
+{
+    // Another process that got the lock after its owner exited compacted it. Our handle is on
+    // the old file, which isn't linked anymore, anything appended there would be lost.
+#ifdef Q_OS_UNIX
+    struct stat opened;
+    struct stat current;
+    if (!m_file.isOpen() || ::fstat(m_file.handle(), &opened) != 0
+        || ::stat(QFile::encodeName(root()).constData(), &current) != 0)
+        return;
+
+    if (opened.st_dev == current.st_dev && opened.st_ino == current.st_ino)
+        return;
+
+    qWarning() << Q_FUNC_INFO << root() << "was replaced by another process, reloading";
+    unload();
+    load();
+#endif
+    // Elsewhere a file that's open can't be replaced, compact() fails instead
+}
+
+void PackedStorage::unload()
+{
+    if (m_map)
+        m_file.unmap(m_map);
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_file.close();
+    m_writable = false;
+    m_liveBytes = 0;
+    m_entries.clear();
+    m_folders.clear();
+    addFolder(QString());
+}
+
+bool PackedStorage::append(RecordType type, const QString &key, const QByteArray &payload)
+{
+    if (!m_writable) {
+        qWarning() << Q_FUNC_INFO << root() << "is read-only";
+        return false;
+    }
+
+    ownsPack(); // So a later process doesn't compact under us once the owner exited
+
+    const QByteArray keyBytes = key.toUtf8();
+    const QByteArray bytes = record(type, keyBytes, payload);
+    const qint64 offset = m_file.size();
+    if (!m_file.seek(offset) || m_file.write(bytes) != bytes.size() || !m_file.flush()) {
+        qWarning() << Q_FUNC_INFO << "Failed to write" << root() << m_file.errorString();
+        m_file.resize(offset);
+        return false;
+    }
+
+    apply(type, key, keyBytes.size(), offset + RecordHeaderSize + keyBytes.size(), payload.size());
+    return true;
+}
+
+void PackedStorage::apply(RecordType type, const QString &key, int keyBytes, qint64 offset, int size)
+{
+    switch (type) {
+    case PutRecord: {
+        auto it = m_entries.find(key);
+        if (it == m_entries.end()) {
+            const QString parent = parentKey(key);
+            addFolder(parent);
+            m_folders[parent].snippets.insert(nameOf(key));
+            it = m_entries.insert(key, Entry());
+        } else {
+            m_liveBytes -= it->recordBytes;
+        }
+
+        it->offset = offset;
+        it->size = size;
+        it->recordBytes = RecordHeaderSize + keyBytes + size;
+        m_liveBytes += it->recordBytes;
+        break;
+    }
+    case RemoveRecord:
+        removeKey(key);
+        break;
+    case FolderRecord:
+        addFolder(key);
+        break;
+    }
+}
+
+void PackedStorage::addFolder(const QString &key)
+{
+    QStringList missing;
+    for (QString folder = key; !m_folders.contains(folder); folder = parentKey(folder)) {
+        missing << folder;
+        if (folder.isEmpty())
+            break;
+    }
+
+    for (int i = missing.size() - 1; i >= 0; --i) {
+        const QString &folder = missing.at(i);
+        m_folders.insert(folder, Folder());
+        if (!folder.isEmpty())
+            m_folders[parentKey(folder)].subFolders.insert(nameOf(folder));
+    }
+}
+
+void PackedStorage::removeKey(const QString &key)
+{
+    auto entry = m_entries.find(key);
+    if (entry != m_entries.end()) {
+        m_liveBytes -= entry->recordBytes;
+        m_entries.erase(entry);
+        m_folders[parentKey(key)].snippets.remove(nameOf(key));
+        return;
+    }
+
+    if (key.isEmpty() || !m_folders.contains(key))
+        return;
+
+    const QString prefix = key + QLatin1Char('/');
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it.key().startsWith(prefix)) {
+            m_liveBytes -= it->recordBytes;
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = m_folders.begin(); it != m_folders.end();) {
+        if (it.key() == key || it.key().startsWith(prefix))
+            it = m_folders.erase(it);
+        else
+            ++it;
+    }
+
+    m_folders[parentKey(key)].subFolders.remove(nameOf(key));
+}
+
+QByteArray PackedStorage::bytesAt(qint64 offset, qint64 size)
+{
+    // Appends make the file outgrow the mapping, remap on demand
+    if (offset + size > m_mapSize) {
+        if (m_map)
+            m_file.unmap(m_map);
+        m_mapSize = m_file.size();
+        m_map = m_mapSize > 0 ? m_file.map(0, m_mapSize) : nullptr;
+        if (!m_map)
+            m_mapSize = 0;
+    }
+
+    if (m_map && offset + size <= m_mapSize)
+        return QByteArray(reinterpret_cast<const char *>(m_map + offset), int(size));
+
+    // Not mappable, on some network filesystems
+    if (!m_file.seek(offset))
+        return {};
+    return m_file.read(size);
+}
+
+QString PackedStorage::key(const QString &absolutePath) const
+{
+    return absolutePath.size() <= root().size() ? QString() : absolutePath.mid(root().size() + 1);
+}
+
+/*static*/
+QString PackedStorage::parentKey(const QString &key)
+{
+    const int slash = key.lastIndexOf(QLatin1Char('/'));
+    return slash < 0 ? QString() : key.left(slash);
+}
+
+/*static*/
+QString PackedStorage::nameOf(const QString &key)
+{
+    return key.mid(key.lastIndexOf(QLatin1Char('/')) + 1);
+}
@@ -0,0 +1,107 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_PACKED_STORAGE_H
+#define SNIPPY_PACKED_STORAGE_H
+
+#include "snippetstorage.h"
+
+#include <QFile>
+#include <QHash>
+#include <QLockFile>
+#include <QMutex>
+#include <QSet>
+
+// All snippets in a single .snippack file, to avoid an inode and a few syscalls per snippet.
+//
+// The file is a header followed by append-only records: a snippet was written, a path was
+// removed, or an empty folder was created. Editing a snippet appends a new version of it,
+// a torn record at the end, from a crash, is ignored. The offset index is built by walking
+// the record headers of the memory-mapped file on open, bodies are read from the mapping.
+// Overwritten records are garbage until compact() rewrites the file with only live ones.
+// Other processes may have the pack mapped, so only the one holding its lock file compacts.
+// One that opened the pack while another held the lock reloads before writing if the pack
+// was compacted meanwhile, rather than appending to the replaced file.
+
+class PackedStorage : public SnippetStorage
+{
+public:
+    explicit PackedStorage(const QString &packPath);
+    ~PackedStorage() override;
+
+    bool list(const QString &folderPath, QStringList &snippetNames, QStringList &subFolders) override;
+    bool read(const QString &absolutePath, SnippetData &data, bool headerOnly = false) override;
+    bool write(const QString &absolutePath, const QString &title,
+               const QStringList &tags, const QString &contents) override;
+    bool remove(const QString &absolutePath) override;
+    bool exists(const QString &absolutePath) override;
+    bool makeFolder(const QString &absolutePath) override;
+    bool renameFolder(const QString &absolutePath, const QString &newAbsolutePath) override;
+    bool makeEditable(const QString &absolutePath) override; // Always false, paths are virtual
+
+    bool compact();
+
+private:
+    enum RecordType {
+        PutRecord = 1,
+        RemoveRecord,
+        FolderRecord
+    };
+
+    struct Entry
+    {
+        qint64 offset = 0; // Of the payload
+        int size = 0;
+        int recordBytes = 0; // Header, key and payload
+    };
+
+    struct Folder
+    {
+        QSet<QString> snippets;
+        QSet<QString> subFolders;
+    };
+
+    bool load();
+    void unload();
+    bool ownsPack(); // Takes the lock file if nobody holds it
+    void reloadIfReplaced(); // Before changing anything, in case another process compacted
+    bool append(RecordType, const QString &key, const QByteArray &payload = {});
+    void apply(RecordType, const QString &key, int keyBytes, qint64 offset, int size);
+    void addFolder(const QString &key); // And any missing ancestors
+    void removeKey(const QString &key); // A snippet, or a folder and everything below it
+    QByteArray bytesAt(qint64 offset, qint64 size);
+    QString key(const QString &absolutePath) const; // Relative to the root, "" for the root itself
+    static QString parentKey(const QString &key);
+    static QString nameOf(const QString &key);
+
+    QMutex m_mutex;
+    QLockFile m_lock;
+    QFile m_file;
+    uchar *m_map = nullptr;
+    qint64 m_mapSize = 0;
+    qint64 m_liveBytes = 0; // Records of current snippets, the rest of the file is garbage
+    bool m_writable = false;
+    QHash<QString, Entry> m_entries; // Snippets by key
+    QHash<QString, Folder> m_folders; // By key, "" is the root
+};
+
+#endif
@@ -0,0 +1,99 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "pathnode.h"
+#include "memorystats.h"
+
+quint64 PathNode::s_generation = 1;
+quint64 PathNode::s_lastStamp = 0;
+
+PathNode::PathNode(const QString &name, const PathNode *parent)
+    : m_name(name)
+    , m_parent(parent)
+{
+}
+
+QString PathNode::name() const
+{
+    return m_name;
+}
+
+void PathNode::setName(const QString &name)
+{
+    if (name != m_name) {
+        m_name = name;
+        m_cacheStamp = 0;
+        ++s_generation;
+    }
+}
+
+const PathNode *PathNode::parent() const
+{
+    return m_parent;
+}
+
+QString PathNode::absolutePath() const
+{
+    updateCache();
+    return m_absolutePath;
+}
+
+QString PathNode::relativePath() const
+{
+    updateCache();
+    return m_relativePath;
+}
+
+void PathNode::updateCache() const
+{
+    if (m_checkedGeneration == s_generation)
+        return;
+
+    // Something was renamed, but maybe not an ancestor. Walking up costs no allocations.
+    quint64 parentStamp = 0;
+    if (m_parent) {
+        m_parent->updateCache();
+        parentStamp = m_parent->m_cacheStamp;
+    }
+
+    m_checkedGeneration = s_generation;
+    if (m_cacheStamp != 0 && m_parentStamp == parentStamp)
+        return;
+
+    if (m_parent) {
+        const QString separator = QStringLiteral("/");
+        m_absolutePath = m_parent->absolutePath() + separator + m_name;
+        m_relativePath = m_parent->relativePath() + separator + m_name;
+    } else {
+        m_absolutePath = m_name;
+        m_relativePath.clear();
+    }
+
+    m_parentStamp = parentStamp;
+    m_cacheStamp = ++s_lastStamp;
+}
+
+qint64 PathNode::memoryUsage() const
+{
+    return sizeof(PathNode) + MemoryStats::stringBytes(m_name) + MemoryStats::stringBytes(m_absolutePath)
+        + MemoryStats::stringBytes(m_relativePath);
+}
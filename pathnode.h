@@ -0,0 +1,69 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_PATH_NODE_H
+#define SNIPPY_PATH_NODE_H
+
+#include <QString>
+#include <QMetaType>
+
+// One component of a path, plus a link to its parent.
+// Full paths are built on demand and memoised, so renaming a folder only touches
+// its own node and descendants pick up the new path the next time they're asked.
+// Nodes outside the renamed subtree keep their memoised paths.
+
+class PathNode
+{
+public:
+    explicit PathNode(const QString &name, const PathNode *parent = nullptr);
+
+    QString name() const;
+    void setName(const QString &);
+    const PathNode *parent() const;
+
+    QString absolutePath() const;
+
+    // Relative to the top-most ancestor, with a leading '/'. Empty for the top-most node.
+    QString relativePath() const;
+
+    qint64 memoryUsage() const; // Including the caches
+
+private:
+    void updateCache() const;
+
+    QString m_name;
+    const PathNode *const m_parent;
+    mutable QString m_absolutePath;
+    mutable QString m_relativePath;
+    mutable quint64 m_checkedGeneration = 0; // Last s_generation the cache was known valid at
+    mutable quint64 m_cacheStamp = 0; // 0 if stale, otherwise unique per rebuild
+    mutable quint64 m_parentStamp = 0; // The parent's m_cacheStamp when this cache was built
+
+    // Bumped on every rename. Caches from older generations are checked against their
+    // parents' stamps, only the renamed node and its descendants rebuild their paths.
+    static quint64 s_generation;
+    static quint64 s_lastStamp;
+};
+
+Q_DECLARE_METATYPE(PathNode *)
+
+#endif
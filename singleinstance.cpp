@@ -0,0 +1,99 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "singleinstance.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QCryptographicHash>
+#include <QDebug>
+
+enum {
+    ConnectTimeout = 200, // ms
+    WriteTimeout = 1000 // ms
+};
+
+SingleInstance::SingleInstance(QObject *parent)
+    : QObject(parent)
+{
+}
+
+bool SingleInstance::forwardToRunningInstance(const QString &filter)
+{
+    QLocalSocket socket;
+    socket.connectToServer(serverName());
+    if (!socket.waitForConnected(ConnectTimeout))
+        return false;
+
+    socket.write(filter.toUtf8() + '\n');
+    if (!socket.waitForBytesWritten(WriteTimeout)) {
+        qWarning() << Q_FUNC_INFO << "Failed to forward filter to running instance:" << socket.errorString();
+        return false;
+    }
+
+    socket.disconnectFromServer();
+    return true;
+}
+
+bool SingleInstance::listen()
+{
+    if (!m_server) {
+        m_server = new QLocalServer(this);
+        m_server->setSocketOptions(QLocalServer::UserAccessOption);
+        connect(m_server, &QLocalServer::newConnection, this, &SingleInstance::onNewConnection);
+    }
+
+    const QString name = serverName();
+    if (m_server->listen(name))
+        return true;
+
+    // We only get here if nobody answered on this name, so it's a stale socket left by a crash
+    QLocalServer::removeServer(name);
+    if (m_server->listen(name))
+        return true;
+
+    qWarning() << Q_FUNC_INFO << "Failed to listen on" << name << m_server->errorString();
+    return false;
+}
+
+void SingleInstance::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket] {
+            if (!socket->canReadLine())
+                return;
+
+            const QString filter = QString::fromUtf8(socket->readLine()).trimmed();
+            socket->disconnectFromServer();
+            emit activationRequested(filter);
+        });
+    }
+}
+
+/*static*/
+QString SingleInstance::serverName()
+{
+    // One instance per user and per data folder
+    QByteArray key = qgetenv("USER") + '|' + qgetenv("SNIPPY_FOLDER");
+    return QStringLiteral("snippy-") + QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Md5).toHex());
+}
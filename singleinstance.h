@@ -1,5 +1,5 @@
 /*
-  Copyright (c) 2016 Sergio Martins <iamsergio@gmail.com>
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
 
   This program is free software; you can redistribute it and/or modify
   it under the terms of the GNU General Public License as published by
@@ -20,32 +20,36 @@
   without including the source code for Qt in the source distribution.
 */
 
-#include "removeemptyfoldersproxymodel.h"
-#include "snippetmodel.h"
-#include <QDebug>
+#ifndef SNIPPY_SINGLE_INSTANCE_H
+#define SNIPPY_SINGLE_INSTANCE_H
 
-RemoveEmptyFoldersProxyModel::RemoveEmptyFoldersProxyModel(QObject *parent)
-    : QSortFilterProxyModel(parent)
-{
-}
+#include <QObject>
+#include <QString>
 
-void RemoveEmptyFoldersProxyModel::setAcceptsEmptyParents(bool accepts)
-{
-    if (accepts != m_acceptsEmptyParents) {
-        m_acceptsEmptyParents = accepts;
-        invalidateFilter();
-    }
-}
-
-bool RemoveEmptyFoldersProxyModel::filterAcceptsRow(int source_row,
-                                                    const QModelIndex &source_parent) const
+class QLocalServer;
+
+// Makes sure only one snippy runs per user and data folder.
+// A second launch hands its filter to the running instance and exits, instead of paying a full load.
+
+class SingleInstance : public QObject
 {
-    if (m_acceptsEmptyParents)
-        return true;
+    Q_OBJECT
+public:
+    explicit SingleInstance(QObject *parent = nullptr);
+
+    // Returns true if another instance is running and accepted the filter
+    bool forwardToRunningInstance(const QString &filter);
+
+    // Starts accepting filters from instances launched after us
+    bool listen();
+
+Q_SIGNALS:
+    void activationRequested(const QString &filter);
 
-    auto sourceIndex = sourceModel()->index(source_row, 0, source_parent);
-    if (sourceIndex.data(SnippetModel::IsFolderRole).toBool())
-        return sourceModel()->rowCount(sourceIndex) > 0;
+private:
+    void onNewConnection();
+    static QString serverName();
+    QLocalServer *m_server = nullptr;
+};
 
-    return true;
-}
+#endif
@@ -21,25 +21,56 @@
 */
 
 #include "snippet.h"
+#include "bodystore.h"
+#include "filterquery.h"
+#include "snippetstorage.h"
 
-#include <QFile>
-#include <QTextStream>
+#include "memorystats.h"
+#include "tracer.h"
+
+#include <QDateTime>
 #include <QDebug>
+#include <QRegularExpression>
 
-Snippet::Snippet(const QString &absolutePath, QObject *parent)
+Snippet::Snippet(const PathNode *folder, const QString &fileName, QObject *parent)
     : QObject(parent)
-    , m_absolutePath(absolutePath)
+    , m_pathNode(fileName, folder)
+    , m_bodyId(BodyStore::instance().add())
 {
     m_timer.setSingleShot(true);
-    QObject::connect(&m_timer, &QTimer::timeout, this, &Snippet::saveToFile);
+    QObject::connect(&m_timer, &QTimer::timeout, this, &Snippet::save);
     loadFromFile();
 }
 
+Snippet::Snippet(const SnippetData &data, const PathNode *folder, QObject *parent)
+    : QObject(parent)
+    , m_pathNode(data.absolutePath.mid(data.absolutePath.lastIndexOf(QLatin1Char('/')) + 1), folder)
+    , m_title(data.title)
+    , m_bodyId(data.hasContents ? BodyStore::instance().add(data.contents) : BodyStore::instance().add())
+    , m_size(data.size)
+    , m_modified(data.modified)
+{
+    assignTags(TagDictionary::instance().tagIds(data.tags));
+    m_timer.setSingleShot(true);
+    QObject::connect(&m_timer, &QTimer::timeout, this, &Snippet::save);
+}
+
+Snippet::~Snippet()
+{
+    // Don't lose edits that were still waiting for the save timer
+    if (m_timer.isActive())
+        saveToFile();
+
+    TagDictionary::instance().removeUsage(m_tags);
+    BodyStore::instance().remove(m_bodyId);
+}
+
 void Snippet::setTitle(const QString &title)
 {
     if (title != m_title) {
         m_title = title;
         scheduleSave();
+        emit titleChanged();
     }
 }
 
@@ -50,30 +81,102 @@ QString Snippet::title() const
 
 QString Snippet::absolutePath() const
 {
-    return m_absolutePath;
+    return m_pathNode.absolutePath();
+}
+
+QString Snippet::fileName() const
+{
+    return m_pathNode.name();
+}
+
+QString Snippet::relativePath() const
+{
+    return m_pathNode.relativePath();
+}
+
+const PathNode *Snippet::folder() const
+{
+    return m_pathNode.parent();
 }
 
 QString Snippet::contents() const
 {
-    return m_contents;
+    QString contents;
+    readContents(contents);
+    return contents;
+}
+
+bool Snippet::readContents(QString &contents) const
+{
+    BodyStore &store = BodyStore::instance();
+    if (store.body(m_bodyId, contents))
+        return true;
+
+    // Only the header was read, or the store dropped it. Not kept if that failed, it's
+    // worth another try and mustn't be saved as the body.
+    SnippetData data;
+    if (!SnippetStorage::forPath(absolutePath())->read(absolutePath(), data)) {
+        qWarning() << Q_FUNC_INFO << "Could not read the body of" << absolutePath();
+        contents.clear();
+        return false;
+    }
+
+    contents = data.contents;
+    store.setBody(m_bodyId, contents);
+    return true;
 }
 
 void Snippet::setContents(const QString &contents)
 {
-    if (contents != m_contents) {
-        m_contents = contents;
+    if (contents != this->contents()) {
+        BodyStore::instance().setBody(m_bodyId, contents, /*dirty=*/true);
         scheduleSave();
     }
 }
 
+bool Snippet::contentsContain(const QString &text) const
+{
+    const BodyStore::Lookup lookup = BodyStore::instance().find(m_bodyId, text, Qt::CaseInsensitive);
+    if (lookup != BodyStore::NotResident)
+        return lookup == BodyStore::Found;
+
+    return SnippetStorage::forPath(absolutePath())->contains(absolutePath(), text);
+}
+
+bool Snippet::contentsMatch(const QRegularExpression &pattern) const
+{
+    const BodyStore::Lookup lookup = BodyStore::instance().find(m_bodyId, pattern);
+    if (lookup != BodyStore::NotResident)
+        return lookup == BodyStore::Found;
+
+    // Not kept, a filter pass over a large corpus would push everything else out
+    SnippetData data;
+    return SnippetStorage::forPath(absolutePath())->read(absolutePath(), data) && FilterQuery::matchPattern(pattern, data.contents);
+}
+
+qint64 Snippet::size() const
+{
+    return m_size;
+}
+
+qint64 Snippet::modified() const
+{
+    return m_modified;
+}
+
 QStringList Snippet::tags() const
+{
+    return TagDictionary::instance().tags(m_tagIds);
+}
+
+const TagSet &Snippet::tagSet() const
 {
     return m_tags;
 }
 
 QString Snippet::tagsString() const
 {
-    return m_tags.join(QChar(';'));
+    return tags().join(QChar(';'));
 }
 
 void Snippet::setTags(const QString &tagsStr)
@@ -83,9 +186,11 @@ void Snippet::setTags(const QString &tagsStr)
 
 void Snippet::setTags(const QStringList &tags)
 {
-    if (tags != m_tags) {
-        m_tags = tags;
+    const QVector<int> ids = TagDictionary::instance().tagIds(tags);
+    if (ids != m_tagIds) { // Reordering counts too, it's saved
+        assignTags(ids);
         scheduleSave();
+        emit tagsChanged();
     }
 }
 
@@ -94,57 +199,66 @@ bool Snippet::isValid() const
     return !m_title.isEmpty();
 }
 
-enum {
-    TitleLine = 0,
-    TagsLine = 1
-};
-
 void Snippet::loadFromFile()
 {
-    QFile file(m_absolutePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qWarning() << Q_FUNC_INFO << "Failed to open " << m_absolutePath << " due to " << file.errorString();
+    SNIPPY_TRACE_ARGS("Snippet::loadFromFile", absolutePath());
+    SnippetData data;
+    if (!SnippetStorage::forPath(absolutePath())->read(absolutePath(), data))
         return;
-    }
 
-    int i = 0;
-    while (!file.atEnd()) {
-        const QString line = QString::fromUtf8(file.readLine());
+    m_title = data.title;
+    assignTags(TagDictionary::instance().tagIds(data.tags));
+    BodyStore::instance().setBody(m_bodyId, data.contents);
+    m_size = data.size;
+    m_modified = data.modified;
+}
 
-        if (i == TitleLine) {
-            m_title = line.trimmed();
-        } else if (i == TagsLine) {
-            m_tags = line.trimmed().split(";");
-        } else {
-            m_contents += line;
-        }
+bool Snippet::saveToFile() const
+{
+    SNIPPY_TRACE_ARGS("Snippet::saveToFile", absolutePath());
+    QString contents; // Before truncating, it might not be loaded yet
+    if (!readContents(contents))
+        return false; // Rather than replacing the body with nothing
 
-        ++i;
-    }
+    if (!SnippetStorage::forPath(absolutePath())->write(absolutePath(), m_title, tags(), contents))
+        return false;
 
-    if (!isValid()) {
-        qWarning() << Q_FUNC_INFO << "Invalid snippet" << m_absolutePath;
-    }
+    BodyStore::instance().setClean(m_bodyId);
+    m_size = SnippetStorage::serialize(m_title, tags(), contents).size(); // Close enough, bodies can be compressed
+    m_modified = QDateTime::currentMSecsSinceEpoch();
+    qDebug() << Q_FUNC_INFO << "Saved" << absolutePath();
+    return true;
 }
 
-bool Snippet::saveToFile() const
+void Snippet::save()
 {
-    QFile file(m_absolutePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qWarning() << Q_FUNC_INFO << "Failed to save file" << m_absolutePath << "because" << file.errorString();
-        return false;
-    }
+    if (saveToFile())
+        emit saved();
+}
 
-    QTextStream out(&file);
-#ifndef OPTION_QT6
-    out.setCodec("UTF-8");
-#endif
-    out << m_title << "\n"
-        << tagsString() << "\n"
-        << m_contents;
+qint64 Snippet::memoryUsage() const
+{
+    enum {
+        QObjectPrivateBytes = 120, // Roughly, what QObject and QTimer allocate behind their d-pointers
+        QTimerPrivateBytes = 120
+    };
 
-    qDebug() << Q_FUNC_INFO << "Saved" << m_absolutePath;
-    return true;
+    return sizeof(Snippet) + QObjectPrivateBytes + QTimerPrivateBytes
+        + MemoryStats::stringBytes(m_title) + m_pathNode.memoryUsage() - qint64(sizeof(PathNode))
+        + m_tags.memoryUsage() - qint64(sizeof(TagSet)) + m_tagIds.capacity() * qint64(sizeof(int));
+}
+
+void Snippet::assignTags(const QVector<int> &ids)
+{
+    TagSet tags;
+    for (int id : ids)
+        tags.insert(id);
+
+    TagDictionary &dictionary = TagDictionary::instance();
+    dictionary.removeUsage(m_tags);
+    dictionary.addUsage(tags);
+    m_tags = tags;
+    m_tagIds = ids;
 }
 
 void Snippet::scheduleSave()
@@ -23,42 +23,87 @@
 #ifndef SNIPPY_SNIPPET_H
 #define SNIPPY_SNIPPET_H
 
+#include "pathnode.h"
+#include "tagdictionary.h"
+
 #include <QString>
 #include <QStringList>
 #include <QVariant>
 #include <QTimer>
 
+class QRegularExpression;
+
+// The parsed contents of a snippet, see SnippetStorage.
+// Plain data, so it can be filled by a worker thread and handed to the GUI thread.
+struct SnippetData
+{
+    QString absolutePath;
+    QString title;
+    QStringList tags;
+    QString contents;
+    bool hasContents = true; // false if only the title and tags were read
+    qint64 size = 0; // Bytes as stored
+    qint64 modified = 0; // Milliseconds since the epoch, 0 if unknown
+};
+
 class Snippet : public QObject
 {
     Q_OBJECT
 public:
-    explicit Snippet(const QString &absoluteFileName,
+    // folder is owned by the model and outlives the snippet
+    explicit Snippet(const PathNode *folder, const QString &fileName,
                      QObject *parent = nullptr);
+    explicit Snippet(const SnippetData &data, const PathNode *folder, QObject *parent = nullptr);
+    ~Snippet() override;
 
     QString title() const;
     void setTitle(const QString &);
 
     QString absolutePath() const;
+    QString fileName() const;
+    QString relativePath() const; // Relative to the data folder
+    const PathNode *folder() const;
 
-    QString contents() const;
+    QString contents() const; // Empty if it couldn't be read, tried again next time
     void setContents(const QString &);
+    bool contentsContain(const QString &text) const; // Case insensitive, doesn't make the body hot
+    bool contentsMatch(const QRegularExpression &) const; // Doesn't make the body hot either
+
+    // As last read or saved, for sorting
+    qint64 size() const;
+    qint64 modified() const;
 
     QStringList tags() const;
+    const TagSet &tagSet() const;
     QString tagsString() const;
     void setTags(const QString &tagsStr);
     void setTags(const QStringList &tags);
     bool isValid() const;
 
+    // Through the SnippetStorage that holds absolutePath()
     void loadFromFile();
     bool saveToFile() const;
 
+    qint64 memoryUsage() const; // Of the object itself, the body is accounted by BodyStore
+
+Q_SIGNALS:
+    void titleChanged();
+    void tagsChanged();
+    void saved(); // By the save timer, size() and modified() changed
+
 private:
     void scheduleSave();
-    const QString m_absolutePath;
+    void save();
+    bool readContents(QString &contents) const; // Re-reads it if BodyStore doesn't have it
+    void assignTags(const QVector<int> &ids); // Keeps TagDictionary's usage counts in sync
+    PathNode m_pathNode;
     QTimer m_timer;
     QString m_title;
-    QString m_contents;
-    QStringList m_tags;
+    const int m_bodyId; // In BodyStore
+    TagSet m_tags; // Ids into TagDictionary
+    QVector<int> m_tagIds; // The same ids, in the user's order
+    mutable qint64 m_size = 0; // Both updated by saveToFile()
+    mutable qint64 m_modified = 0;
 };
 
 #endif
@@ -0,0 +1,117 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "snippetindex.h"
+#include "snippetscanner.h"
+
+void SnippetIndex::clear(const QString &rootPath)
+{
+    m_rootPath = rootPath;
+    m_entriesByFolder.clear();
+    m_count = 0;
+}
+
+void SnippetIndex::add(const ScannedFolder &folder)
+{
+    QVector<Entry> &entries = m_entriesByFolder[folder.absolutePath];
+    entries.reserve(entries.size() + folder.snippets.size());
+    for (const SnippetData &data : folder.snippets)
+        entries.append({ data.title, data.tags });
+
+    m_count += folder.snippets.size();
+}
+
+void SnippetIndex::renameFolder(const QString &absolutePath, const QString &newAbsolutePath)
+{
+    // Sub-folders aren't necessarily right after the folder itself, see matches()
+    QVector<QString> keys;
+    auto it = m_entriesByFolder.constFind(absolutePath);
+    if (it != m_entriesByFolder.constEnd())
+        keys.append(it.key());
+
+    const QString prefix = absolutePath + QLatin1Char('/');
+    for (it = m_entriesByFolder.lowerBound(prefix); it != m_entriesByFolder.constEnd() && it.key().startsWith(prefix); ++it)
+        keys.append(it.key());
+
+    for (const QString &key : keys)
+        m_entriesByFolder.insert(newAbsolutePath + key.mid(absolutePath.size()), m_entriesByFolder.take(key));
+}
+
+int SnippetIndex::count() const
+{
+    return m_count;
+}
+
+MemoryUsage SnippetIndex::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.objects = m_count;
+    for (auto it = m_entriesByFolder.cbegin(), end = m_entriesByFolder.cend(); it != end; ++it) {
+        usage.bytes += MemoryStats::stringBytes(it.key()) + it.value().capacity() * qint64(sizeof(Entry));
+        for (const Entry &entry : it.value()) {
+            usage.bytes += MemoryStats::stringBytes(entry.title);
+            for (const QString &tag : entry.tags)
+                usage.bytes += MemoryStats::stringBytes(tag);
+        }
+    }
+
+    return usage;
+}
+
+bool SnippetIndex::matches(const QString &folderPath, const FilterQuery::Term &term, bool foldersOnly) const
+{
+    auto it = m_entriesByFolder.constFind(folderPath);
+    if (it != m_entriesByFolder.constEnd() && folderMatches(it, term, foldersOnly))
+        return true;
+
+    // Sub-folders are contiguous in the map, but not necessarily right after folderPath itself
+    const QString prefix = folderPath + QLatin1Char('/');
+    for (it = m_entriesByFolder.lowerBound(prefix); it != m_entriesByFolder.constEnd() && it.key().startsWith(prefix); ++it) {
+        if (folderMatches(it, term, foldersOnly))
+            return true;
+    }
+
+    return false;
+}
+
+bool SnippetIndex::folderMatches(QMap<QString, QVector<Entry>>::const_iterator it,
+                                 const FilterQuery::Term &term, bool foldersOnly) const
+{
+    const QString relativePath = it.key().mid(m_rootPath.size());
+    if (term.matches(relativePath))
+        return true;
+
+    if (foldersOnly)
+        return false;
+
+    for (const Entry &entry : it.value()) {
+        if (term.matches(entry.title))
+            return true;
+
+        for (const QString &tag : entry.tags) {
+            if (term.matches(tag))
+                return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,65 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_SNIPPET_INDEX_H
+#define SNIPPY_SNIPPET_INDEX_H
+
+#include "filterquery.h"
+#include "memorystats.h"
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+struct ScannedFolder;
+
+// Titles and tags of every snippet, grouped by folder.
+// In browse mode it answers filter queries for folders that weren't fetched yet.
+class SnippetIndex
+{
+public:
+    void clear(const QString &rootPath);
+    void add(const ScannedFolder &);
+    void renameFolder(const QString &absolutePath, const QString &newAbsolutePath); // And what's below
+    int count() const;
+    MemoryUsage memoryUsage() const;
+
+    // Returns true if something below folderPath matches the term, by folder path, title or tag
+    bool matches(const QString &folderPath, const FilterQuery::Term &, bool foldersOnly) const;
+
+private:
+    struct Entry
+    {
+        QString title;
+        QStringList tags;
+    };
+
+    bool folderMatches(QMap<QString, QVector<Entry>>::const_iterator it,
+                       const FilterQuery::Term &, bool foldersOnly) const;
+
+    QString m_rootPath;
+    QMap<QString, QVector<Entry>> m_entriesByFolder; // Key is the absolute folder path
+    int m_count = 0;
+};
+
+#endif
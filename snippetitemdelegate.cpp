@@ -0,0 +1,84 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "snippetitemdelegate.h"
+#include "snippetmodel.h"
+
+#include <QApplication>
+#include <QPainter>
+#include <QTextLayout>
+
+SnippetItemDelegate::SnippetItemDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+void SnippetItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    const QVector<MatchSpan> spans = index.data(SnippetModel::TitleMatchSpansRole).value<QVector<MatchSpan>>();
+    if (spans.isEmpty()) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    QStyleOptionViewItem opt = option;
+    initStyleOption(&opt, index);
+    const QString text = opt.text;
+    opt.text.clear(); // The style draws the background, selection and focus, the text is ours
+
+    const QWidget *widget = opt.widget;
+    QStyle *style = widget ? widget->style() : QApplication::style();
+    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+
+    // Same look as the editor's highlighting
+    QTextCharFormat format;
+    format.setFontWeight(QFont::Bold);
+    format.setForeground(Qt::darkBlue);
+    format.setBackground(Qt::yellow);
+
+    QVector<QTextLayout::FormatRange> ranges;
+    ranges.reserve(spans.size());
+    for (const MatchSpan &span : spans)
+        ranges.append({ span.start, span.length, format });
+
+    const QRect rect = style->subElementRect(QStyle::SE_ItemViewItemText, &opt, widget);
+    const int margin = style->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, widget) + 1;
+
+    QTextOption textOption;
+    textOption.setWrapMode(QTextOption::NoWrap); // One line, clipped rather than elided
+
+    QTextLayout layout(text, opt.font);
+    layout.setTextOption(textOption);
+    layout.setFormats(ranges);
+    layout.beginLayout();
+    QTextLine line = layout.createLine();
+    line.setLineWidth(rect.width());
+    layout.endLayout();
+
+    painter->save();
+    painter->setClipRect(rect);
+    const QPalette::ColorGroup group = opt.state & QStyle::State_Enabled ? QPalette::Normal : QPalette::Disabled;
+    painter->setPen(opt.palette.color(group, opt.state & QStyle::State_Selected ? QPalette::HighlightedText : QPalette::Text));
+    const qreal y = rect.top() + (rect.height() - line.height()) / 2;
+    layout.draw(painter, QPointF(rect.left() + margin, y));
+    painter->restore();
+}
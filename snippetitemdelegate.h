@@ -1,5 +1,5 @@
 /*
-  Copyright (c) 2016 Sergio Martins <iamsergio@gmail.com>
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
 
   This program is free software; you can redistribute it and/or modify
   it under the terms of the GNU General Public License as published by
@@ -20,26 +20,19 @@
   without including the source code for Qt in the source distribution.
 */
 
-#ifndef REMOVEEMPTYFOLDERSPROXYMODEL_H
-#define REMOVEEMPTYFOLDERSPROXYMODEL_H
+#ifndef SNIPPY_SNIPPET_ITEM_DELEGATE_H
+#define SNIPPY_SNIPPET_ITEM_DELEGATE_H
 
-#include <QSortFilterProxyModel>
+#include <QStyledItemDelegate>
 
-// Removes rows that are folders with no files in it
-// Doing this in a second filter pass is much simpler than doing it all in the same proxy model
+// Paints where the filter matched a title, from SnippetModel::TitleMatchSpansRole.
+// Rows without spans are left to QStyledItemDelegate.
 
-class RemoveEmptyFoldersProxyModel : public QSortFilterProxyModel
+class SnippetItemDelegate : public QStyledItemDelegate
 {
-    Q_OBJECT
 public:
-    explicit RemoveEmptyFoldersProxyModel(QObject *parent = nullptr);
-    void setAcceptsEmptyParents(bool);
-
-protected:
-    bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
-
-private:
-    bool m_acceptsEmptyParents = true;
+    explicit SnippetItemDelegate(QObject *parent = nullptr);
+    void paint(QPainter *, const QStyleOptionViewItem &, const QModelIndex &) const override;
 };
 
 #endif
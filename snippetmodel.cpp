@@ -21,20 +21,32 @@
 */
 
 #include "snippetmodel.h"
+#include "snippetscanner.h"
+#include "snippetstorage.h"
+#include "tracer.h"
 
 #include <QStandardPaths>
 #include <QStandardItem>
 #include <QDir>
+#include <QFileInfo>
 #include <QDebug>
 #include <QStyle>
 #include <QApplication>
-#include <QFile>
 #include <QUuid>
+#include <QThread>
 
 SnippetModel::SnippetModel(QObject *parent)
     : QStandardItemModel(parent)
     , m_numSnippets(0)
+    , m_browseMode(qEnvironmentVariableIntValue("SNIPPY_BROWSE_MODE") == 1)
 {
+    connect(&m_publisher, &CorpusPublisher::published, this, &SnippetModel::snapshotPublished);
+}
+
+SnippetModel::~SnippetModel()
+{
+    cancelScan();
+    deleteSnippetsAndNodes();
 }
 
 QVariant SnippetModel::data(const QModelIndex &index, int role) const
@@ -64,10 +76,14 @@ QVariant SnippetModel::data(const QModelIndex &index, int role) const
         }
     }
 
-    if (role == RelativePathRole) {
-        QFileInfo absolute(QStandardItemModel::data(index, AbsolutePathRole).toString());
-        QFileInfo root(rootPath());
-        return absolute.absoluteFilePath().replace(root.absoluteFilePath(), QString());
+    if (role == AbsolutePathRole || role == RelativePathRole) {
+        if (isFolder) {
+            const PathNode *node = folderNode(item);
+            return role == AbsolutePathRole ? node->absolutePath() : node->relativePath();
+        }
+
+        Snippet *snip = snippet(index);
+        return role == AbsolutePathRole ? snip->absolutePath() : snip->relativePath();
     } else if (role == Qt::FontRole) {
         QFont font = QStandardItemModel::data(index, Qt::FontRole).value<QFont>();
         font.setBold(isFolder);
@@ -85,18 +101,33 @@ bool SnippetModel::setData(const QModelIndex &index, const QVariant &value, int
 
     QStandardItem *item = itemFromIndex(index);
     if (isFolder(index)) {
-        const QString currentFolderPath = index.data(AbsolutePathRole).toString();
-        QDir dir(currentFolderPath);
-        dir.cdUp();
-        const QString newFolderPath = dir.absoluteFilePath(text);
-        bool success = dir.rename(currentFolderPath, newFolderPath);
+        PathNode *node = item->data(PathNodeRole).value<PathNode *>();
+        if (!node->parent())
+            return false; // A root
+
+        if (m_pendingScans > 0) {
+            // Chunks still to come and the index are keyed by the old path
+            qWarning() << Q_FUNC_INFO << "Can't rename folders while loading";
+            return false;
+        }
+
+        const QString currentFolderPath = node->absolutePath();
+        const QString newFolderPath = node->parent()->absolutePath() + QLatin1Char('/') + text;
+        bool success = SnippetStorage::forPath(currentFolderPath)->renameFolder(currentFolderPath, newFolderPath);
         if (success) {
+            // Descendants only link to this node, so nothing else needs updating
+            node->setName(text);
             item->setData(text, FolderNameRole);
-            item->setData(newFolderPath, AbsolutePathRole);
+            if (Root *root = rootFor(currentFolderPath))
+                root->index.renameFolder(currentFolderPath, newFolderPath);
+
+            m_publisher.renameFolder(node); // Its folder records link the same way
         }
     } else {
         Snippet *snip = snippet(index);
         snip->setTitle(text);
+        emit dataChanged(index, index, { Qt::DisplayRole, Qt::EditRole });
+        notifyAncestors(item->parent());
     }
 
     return true;
@@ -116,13 +147,251 @@ Snippet *SnippetModel::snippet(const QModelIndex &index) const
 
 void SnippetModel::load()
 {
+    SNIPPY_TRACE("SnippetModel::load");
+    m_loadStart = Tracer::now();
+    cancelScan();
     clear();
-    beginResetModel();
+
+    // Views were told about the reset, nobody holds on to the old snippets anymore
+    deleteSnippetsAndNodes();
+
     m_numSnippets = 0;
-    import(QDir(rootPath()), invisibleRootItem());
-    endResetModel();
+    m_scannedFolders.clear();
+    ++m_loadGeneration;
+
+    const QStringList paths = rootPaths();
+    foreach (const QString &path, paths) {
+        auto root = new Root();
+        root->path = path;
+        root->node = new PathNode(path);
+        root->index.clear(path);
+        m_roots.append(root);
+
+        if (paths.size() == 1) {
+            root->item = invisibleRootItem();
+        } else {
+            root->item = createRootItem(root);
+            appendRow(root->item);
+        }
+    }
+
+    m_pendingScans = m_roots.size();
+    foreach (Root *root, m_roots) {
+        if (!m_browseMode)
+            m_scannedFolders.insert(root->path, root->item);
+
+        startScanner(root); // Which opens the storage, a slow root doesn't hold back the others
+    }
+}
+
+void SnippetModel::startScanner(Root *root)
+{
+    SnippetScanner *scanner = new SnippetScanner(root->path, m_loadGeneration, /*headersOnly=*/m_browseMode);
+    connect(scanner, &SnippetScanner::opened, this, &SnippetModel::onRootOpened, Qt::QueuedConnection);
+    connect(scanner, &SnippetScanner::folderScanned, this, &SnippetModel::onFolderScanned, Qt::QueuedConnection);
+    connect(scanner, &SnippetScanner::finished, this, &SnippetModel::onScanFinished, Qt::QueuedConnection);
+
+    QThread *thread = QThread::create([scanner] {
+        scanner->run();
+    });
+    connect(thread, &QThread::finished, scanner, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+
+    root->scanner = scanner;
+    root->scanThread = thread;
+    thread->start();
+}
+
+bool SnippetModel::isBrowseMode() const
+{
+    return m_browseMode;
+}
+
+bool SnippetModel::hasChildren(const QModelIndex &parent) const
+{
+    // Assume an unread folder has something, the expander goes away once fetched if it doesn't
+    if (parent.isValid() && parent.data(NeedsFetchRole).toBool())
+        return true;
+
+    return QStandardItemModel::hasChildren(parent);
+}
+
+bool SnippetModel::canFetchMore(const QModelIndex &parent) const
+{
+    return parent.isValid() && parent.data(NeedsFetchRole).toBool();
+}
+
+void SnippetModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent))
+        return;
+
+    SNIPPY_TRACE_ARGS("SnippetModel::fetchMore", parent.data(AbsolutePathRole).toString());
+
+    QStandardItem *parentItem = itemFromIndex(parent);
+    appendScannedFolder(SnippetScanner::scanFolder(parent.data(AbsolutePathRole).toString(), /*headersOnly=*/true), parentItem);
+
+    // Only now, so proxies don't see it as an empty folder in between
+    parentItem->setData(false, NeedsFetchRole);
+}
+
+bool SnippetModel::indexMatches(const QModelIndex &folder, const FilterQuery::Term &term, bool foldersOnly) const
+{
+    const QString path = folder.data(AbsolutePathRole).toString();
+    const Root *root = rootFor(path);
+    return root && root->index.matches(path, term, foldersOnly);
+}
+
+void SnippetModel::appendScannedFolder(const ScannedFolder &folder, QStandardItem *parentItem)
+{
+    SNIPPY_TRACE_ARGS("SnippetModel::appendScannedFolder", folder.absolutePath);
+    const PathNode *parentNode = folderNode(parentItem);
+
+    QList<QStandardItem *> items;
+    items.reserve(folder.snippets.size() + folder.subFolders.size());
+    for (const SnippetData &data : folder.snippets)
+        items << createSnippetItem(new Snippet(data, parentNode, this));
+
+    foreach (const QString &foldername, folder.subFolders) {
+        QStandardItem *folderItem = createFolderItem(foldername, parentNode);
+        if (m_browseMode)
+            folderItem->setData(true, NeedsFetchRole);
+        else
+            m_scannedFolders.insert(folder.absolutePath + QLatin1Char('/') + foldername, folderItem);
+        items << folderItem;
+    }
+
+    // One rowsInserted for the whole chunk
+    parentItem->appendRows(items);
+    notifyAncestors(parentItem);
+}
+
+void SnippetModel::onRootOpened(int generation, const QString &rootPath)
+{
+    if (generation != m_loadGeneration)
+        return;
+
+    Root *root = rootFor(rootPath);
+    if (!root)
+        return;
+
+    root->opened = true;
+    if (!m_browseMode)
+        return;
+
+    if (root->item == invisibleRootItem()) {
+        // Only the top-level is read now, the scanner just builds the index
+        appendScannedFolder(SnippetScanner::scanFolder(root->path, /*headersOnly=*/true), root->item);
+    } else {
+        root->item->setData(true, NeedsFetchRole);
+    }
+}
 
-    emit loaded(m_numSnippets, rootPath());
+void SnippetModel::onFolderScanned(const ScannedFolder &folder)
+{
+    if (folder.generation != m_loadGeneration)
+        return; // Left over from a cancelled load
+
+    if (m_browseMode) {
+        if (Root *root = rootFor(folder.absolutePath))
+            root->index.add(folder);
+        return;
+    }
+
+    QStandardItem *parentItem = m_scannedFolders.value(folder.absolutePath);
+    if (!parentItem) {
+        qWarning() << Q_FUNC_INFO << "Unknown folder" << folder.absolutePath;
+        return;
+    }
+
+    appendScannedFolder(folder, parentItem);
+}
+
+void SnippetModel::onScanFinished(int generation, const QString &rootPath)
+{
+    if (generation != m_loadGeneration)
+        return;
+
+    if (Tracer::isEnabled()) // From load() until everything was appended, per root
+        Tracer::record("SnippetModel::load (async)", m_loadStart, Tracer::now() - m_loadStart, rootPath);
+
+    if (--m_pendingScans > 0)
+        return;
+
+    m_scannedFolders.clear();
+    emit loaded(snippetCount(), rootPaths().join(QDir::listSeparator()));
+}
+
+void SnippetModel::cancelScan()
+{
+    foreach (Root *root, m_roots) {
+        if (root->scanner)
+            root->scanner->cancel();
+    }
+
+    foreach (Root *root, m_roots) {
+        if (root->scanThread)
+            root->scanThread->wait();
+    }
+}
+
+const PathNode *SnippetModel::folderNode(const QStandardItem *folderItem) const
+{
+    if (!folderItem || folderItem == invisibleRootItem())
+        return m_roots.size() == 1 ? m_roots.first()->node : nullptr;
+
+    return folderItem->data(PathNodeRole).value<PathNode *>();
+}
+
+void SnippetModel::deleteSnippetsAndNodes()
+{
+    // Snippets first, they might still save to a path built from the nodes
+    m_publisher.clear();
+    qDeleteAll(findChildren<Snippet *>(QString(), Qt::FindDirectChildrenOnly));
+    qDeleteAll(m_folderNodes);
+    m_folderNodes.clear();
+    foreach (Root *root, m_roots)
+        delete root->node;
+    qDeleteAll(m_roots);
+    m_roots.clear();
+}
+
+SnippetModel::Root *SnippetModel::rootFor(const QString &absolutePath) const
+{
+    Root *best = nullptr;
+    foreach (Root *root, m_roots) {
+        const bool contains = absolutePath.startsWith(root->path)
+            && (absolutePath.size() == root->path.size() || absolutePath.at(root->path.size()) == QLatin1Char('/'));
+        if (contains && (!best || root->path.size() > best->path.size()))
+            best = root;
+    }
+
+    return best;
+}
+
+bool SnippetModel::isOpened(const PathNode *folder) const
+{
+    const Root *root = folder ? rootFor(folder->absolutePath()) : nullptr;
+    if (root && root->opened)
+        return true;
+
+    qWarning() << Q_FUNC_INFO << "The storage of" << (folder ? folder->absolutePath() : QString()) << "is still being opened";
+    return false;
+}
+
+void SnippetModel::notifyAncestors(QStandardItem *item)
+{
+    // Proxies don't look at rows inserted below a folder they filtered out,
+    // so tell them the folder changed. Top-most first, since a proxy only
+    // re-evaluates rows whose parent it already maps.
+    QVector<QStandardItem *> ancestors;
+    for (QStandardItem *it = item; it && it != invisibleRootItem(); it = it->parent())
+        ancestors.append(it); // Not prepend(), that's quadratic in the depth
+
+    for (int i = ancestors.size() - 1; i >= 0; --i) {
+        const QModelIndex idx = ancestors.at(i)->index();
+        emit dataChanged(idx, idx);
+    }
 }
 
 void SnippetModel::removeSnippet(const QModelIndex &index)
@@ -145,34 +414,36 @@ void SnippetModel::removeSnippet(const QModelIndex &index)
         return;
     }
 
+    const QString absolutePath = snippet->absolutePath();
+    QStandardItem *parentItem = itemFromIndex(index.parent());
     removeRow(index.row(), index.parent());
-    if (!QFile::remove(snippet->absolutePath()))
-        qWarning() << "Error removing" << snippet->absolutePath();
+    notifyAncestors(parentItem);
+    m_publisher.remove(snippet);
+    m_numSnippets--;
+    delete snippet; // Flushes a pending save, so do it before removing the file
+    if (!SnippetStorage::forPath(absolutePath)->remove(absolutePath))
+        qWarning() << "Error removing" << absolutePath;
 }
 
 QModelIndex SnippetModel::addSnippet(const QModelIndex &parentIndex)
 {
-    QString parentFolderPath;
-    QStandardItem *parentItem;
-    if (parentIndex.isValid()) {
-        parentFolderPath = parentIndex.data(AbsolutePathRole).toString();
-        parentItem = itemFromIndex(parentIndex);
-    } else {
-        parentFolderPath = rootPath();
-        parentItem = invisibleRootItem();
-    }
-
-    if (parentFolderPath.isEmpty()) {
+    QStandardItem *parentItem = parentFolderItem(parentIndex);
+    const PathNode *parentNode = folderNode(parentItem);
+    if (!parentNode) {
         qWarning() << Q_FUNC_INFO << "Could not retrieve parent folder path for" << parentIndex;
         return {};
     }
 
+    if (!isOpened(parentNode))
+        return {};
+
     QUuid uuid = QUuid::createUuid();
     const QString filename = uuid.toString().replace("{", "").replace("}", "") + ".snip";
-    auto snip = new Snippet(parentFolderPath + "/" + filename, this);
+    auto snip = new Snippet(parentNode, filename, this);
     snip->setTitle("Empty snippet");
     snip->saveToFile();
     QStandardItem *item = addSnippet(snip, parentItem);
+    notifyAncestors(parentItem);
     return indexFromItem(item);
 }
 
@@ -182,38 +453,35 @@ QString SnippetModel::emptySnippetTitle()
     return tr("Empty snippet");
 }
 
-QByteArray SnippetModel::snippetDataFolder() const
+/*static*/
+QByteArray SnippetModel::snippetDataFolder()
 {
     return qgetenv("SNIPPY_FOLDER");
 }
 
 QStandardItem *SnippetModel::createFolder(const QString &name, const QModelIndex &parentIndex)
 {
-    QString parentFolderPath;
-    QStandardItem *parentItem;
-    if (parentIndex.isValid()) {
-        parentFolderPath = parentIndex.data(AbsolutePathRole).toString();
-        parentItem = itemFromIndex(parentIndex);
-    } else {
-        parentFolderPath = rootPath();
-        parentItem = invisibleRootItem();
-    }
-
+    QStandardItem *parentItem = parentFolderItem(parentIndex);
+    const PathNode *parentNode = folderNode(parentItem);
+    const QString parentFolderPath = parentNode ? parentNode->absolutePath() : QString();
     if (parentFolderPath.isEmpty()) {
         qWarning() << Q_FUNC_INFO << "Could not retrieve parent folder path for" << parentIndex;
         return nullptr;
     }
 
-    QDir dir(parentFolderPath);
+    if (!isOpened(parentNode))
+        return nullptr;
+
+    SnippetStorage *storage = SnippetStorage::forPath(parentFolderPath);
     const QString absolutePath = parentFolderPath + "/" + name;
-    if (QFile::exists(absolutePath)) {
+    if (storage->exists(absolutePath)) {
         qWarning() << "Folder already exists" << absolutePath;
         return itemForName(name, parentIndex); // But still return it, so it can be selected
     }
 
     QStandardItem *newItem = nullptr;
-    if (dir.mkpath(name)) {
-        newItem = addFolder(name, parentFolderPath + "/" + name, parentItem);
+    if (storage->makeFolder(absolutePath)) {
+        newItem = addFolder(name, parentItem);
     } else {
         qWarning() << "Failed to create folder" << name;
     }
@@ -222,26 +490,80 @@ QStandardItem *SnippetModel::createFolder(const QString &name, const QModelIndex
 }
 
 QStandardItem *SnippetModel::addSnippet(Snippet *snippet, QStandardItem *parentItem)
+{
+    QStandardItem *fileItem = createSnippetItem(snippet);
+    parentItem->appendRow(fileItem);
+    return fileItem;
+}
+
+QStandardItem *SnippetModel::addFolder(const QString &foldername, QStandardItem *parentItem)
+{
+    QStandardItem *folderItem = createFolderItem(foldername, folderNode(parentItem));
+    parentItem->appendRow(folderItem);
+    return folderItem;
+}
+
+QStandardItem *SnippetModel::createSnippetItem(Snippet *snippet)
 {
     QStandardItem *fileItem = new QStandardItem();
     fileItem->setData(QVariant::fromValue(snippet), SnippetRole);
-    parentItem->appendRow(fileItem);
     m_numSnippets++;
 
+    m_publisher.add(snippet);
+    connect(snippet, &Snippet::titleChanged, this, [this, snippet] {
+        m_publisher.update(snippet);
+    });
+
+    // So the filter and the tag counts catch up with edited tags
+    connect(snippet, &Snippet::tagsChanged, this, [this, fileItem, snippet] {
+        m_publisher.update(snippet);
+        const QModelIndex index = fileItem->index();
+        emit dataChanged(index, index);
+        notifyAncestors(fileItem->parent());
+    });
+
+    connect(snippet, &Snippet::saved, this, [this, fileItem] {
+        if (m_notifySaves) {
+            const QModelIndex index = fileItem->index();
+            emit dataChanged(index, index);
+        }
+    });
+
     return fileItem;
 }
 
-QStandardItem *SnippetModel::addFolder(const QString &foldername,
-                                       const QString &absolutePath, QStandardItem *parentItem)
+QStandardItem *SnippetModel::createFolderItem(const QString &foldername, const PathNode *parentNode)
 {
+    auto node = new PathNode(foldername, parentNode);
+    m_folderNodes.append(node);
+
     QStandardItem *folderItem = new QStandardItem(foldername);
     folderItem->setData(true, IsFolderRole);
     folderItem->setData(foldername, FolderNameRole);
-    folderItem->setData(absolutePath, AbsolutePathRole);
-    parentItem->appendRow(folderItem);
+    folderItem->setData(QVariant::fromValue(node), PathNodeRole);
     return folderItem;
 }
 
+QStandardItem *SnippetModel::createRootItem(const Root *root)
+{
+    const QString name = QFileInfo(root->path).fileName();
+    QStandardItem *item = new QStandardItem(name);
+    item->setData(true, IsFolderRole);
+    item->setData(name, FolderNameRole);
+    item->setData(QVariant::fromValue(root->node), PathNodeRole);
+    item->setData(root->path, Qt::ToolTipRole);
+    item->setEditable(false); // Renaming would move the whole collection
+    return item; // Fetchable in browse mode once opened, see onRootOpened()
+}
+
+QStandardItem *SnippetModel::parentFolderItem(const QModelIndex &parentIndex) const
+{
+    if (parentIndex.isValid())
+        return itemFromIndex(parentIndex);
+
+    return m_roots.size() > 1 ? m_roots.first()->item : invisibleRootItem();
+}
+
 QStandardItem *SnippetModel::itemForName(const QString &name, const QModelIndex &parentIndex)
 {
     const int childCount = rowCount(parentIndex);
@@ -255,31 +577,102 @@ QStandardItem *SnippetModel::itemForName(const QString &name, const QModelIndex
     return nullptr;
 }
 
-void SnippetModel::import(QDir dir, QStandardItem *parentItem)
+/*static*/
+QStringList SnippetModel::rootPaths()
+{
+    const QString env = QString::fromUtf8(snippetDataFolder());
+    QStringList paths = env.split(QDir::listSeparator(), Qt::SkipEmptyParts);
+    if (paths.isEmpty())
+        paths << QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+
+    for (QString &path : paths)
+        path = QDir(path).absolutePath(); // Clean, paths are built by appending components to it
+
+    paths.removeDuplicates();
+    return paths;
+}
+
+MemoryUsage SnippetModel::itemsMemoryUsage() const
 {
-    dir.setNameFilters({ "*.snip" });
-    dir.setFilter(QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks);
-    foreach (const QString &filename, dir.entryList()) {
-        const QString &absoluteFileName = dir.absoluteFilePath(filename);
-        auto snippet = new Snippet(absoluteFileName, this);
-        addSnippet(snippet, parentItem);
+    enum {
+        ItemBytes = 120, // QStandardItem plus its private
+        RoleBytes = int(sizeof(QVariant)) + 8 // One QStandardItemData per role set
+    };
+
+    MemoryUsage usage;
+    QVector<const QStandardItem *> pending = { invisibleRootItem() };
+    while (!pending.isEmpty()) {
+        const QStandardItem *item = pending.takeLast();
+        for (int row = 0, count = item->rowCount(); row < count; ++row) {
+            const QStandardItem *child = item->child(row);
+            const bool isFolder = child->data(IsFolderRole).toBool();
+            usage.objects++;
+            usage.bytes += ItemBytes + (isFolder ? 5 : 1) * RoleBytes + sizeof(void *);
+            if (isFolder) {
+                usage.bytes += MemoryStats::stringBytes(child->text());
+                pending.append(child);
+            }
+        }
+    }
+
+    foreach (const PathNode *node, m_folderNodes) {
+        usage.objects++;
+        usage.bytes += node->memoryUsage();
     }
 
-    dir.setFilter(QDir::AllDirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
-    foreach (const QString &foldername, dir.entryList()) {
-        const QString absolutePath = dir.absoluteFilePath(foldername);
-        QStandardItem *folderItem = addFolder(foldername, absolutePath, parentItem);
-        import(QDir(absolutePath), folderItem);
+    return usage;
+}
+
+MemoryUsage SnippetModel::snippetsMemoryUsage() const
+{
+    MemoryUsage usage;
+    QVector<const QStandardItem *> pending = { invisibleRootItem() };
+    while (!pending.isEmpty()) {
+        const QStandardItem *item = pending.takeLast();
+        for (int row = 0, count = item->rowCount(); row < count; ++row) {
+            const QStandardItem *child = item->child(row);
+            if (auto snippet = child->data(SnippetRole).value<Snippet *>()) {
+                usage.objects++;
+                usage.bytes += snippet->memoryUsage();
+            } else {
+                pending.append(child);
+            }
+        }
     }
+
+    return usage;
+}
+
+std::shared_ptr<const CorpusSnapshot> SnippetModel::snapshot() const
+{
+    return m_publisher.current();
+}
+
+void SnippetModel::setNotifiesSaves(bool notify)
+{
+    m_notifySaves = notify;
+}
+
+int SnippetModel::snippetCount() const
+{
+    if (!m_browseMode)
+        return m_numSnippets;
+
+    // Only the folders that were expanded have items, the index knows about the others
+    int count = 0;
+    foreach (const Root *root, m_roots)
+        count += root->index.count();
+    return count;
 }
 
-QString SnippetModel::rootPath() const
+MemoryUsage SnippetModel::indexMemoryUsage() const
 {
-    static QString path;
-    if (path.isEmpty()) {
-        QByteArray env_path = snippetDataFolder();
-        path = env_path.isEmpty() ? QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) : QString::fromUtf8(env_path);
+    MemoryUsage usage;
+    foreach (const Root *root, m_roots) {
+        const MemoryUsage rootUsage = root->index.memoryUsage();
+        usage.objects += rootUsage.objects;
+        usage.bytes += rootUsage.bytes;
     }
 
-    return path;
+    return usage;
 }
@@ -23,11 +23,17 @@
 #ifndef SNIPPET_MODEL_H
 #define SNIPPET_MODEL_H
 
+#include "corpussnapshot.h"
 #include "snippet.h"
+#include "snippetindex.h"
 #include <QStandardItemModel>
+#include <QPointer>
+#include <QHash>
 
 class QStandardItem;
-class QDir;
+class QThread;
+class SnippetScanner;
+struct ScannedFolder;
 
 class SnippetModel : public QStandardItemModel
 {
@@ -38,33 +44,99 @@ public:
         IsFolderRole,
         FolderNameRole,
         AbsolutePathRole,
-        RelativePathRole
+        RelativePathRole,
+        NeedsFetchRole, // Browse mode: folder contents weren't read yet
+        PathNodeRole, // Folders only, paths are built from the PathNode chain
+        TitleMatchSpansRole // Served by SnippetProxyModel while filtering, a QVector<MatchSpan>
     };
 
     explicit SnippetModel(QObject *parent = nullptr);
+    ~SnippetModel() override;
     QVariant data(const QModelIndex &index, int role) const override;
     bool setData(const QModelIndex &index, const QVariant &value, int role) override;
     bool isFolder(const QModelIndex &index) const;
     Snippet *snippet(const QModelIndex &index) const;
-    void load();
+    void load(); // Asynchronous, rows are inserted as the scanner finds them
+
+    // In browse mode folders are only read when expanded, see SNIPPY_BROWSE_MODE
+    bool isBrowseMode() const;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    // For folders that weren't fetched yet, answers from the index
+    bool indexMatches(const QModelIndex &folder, const FilterQuery::Term &, bool foldersOnly) const;
     void removeSnippet(const QModelIndex &index);
     QModelIndex addSnippet(const QModelIndex &parent);
     QStandardItem *createFolder(const QString &name, const QModelIndex &parent);
 
     static QString emptySnippetTitle();
-    QByteArray snippetDataFolder() const;
+    static QByteArray snippetDataFolder();
+
+    // SNIPPY_FOLDER, folders or .snippack files separated by QDir::listSeparator(), see SnippetStorage.
+    // With several roots each gets a top-level folder, a single one is shown flat.
+    static QStringList rootPaths();
+
+    MemoryUsage itemsMemoryUsage() const; // QStandardItems and folder PathNodes
+    MemoryUsage snippetsMemoryUsage() const; // Snippet objects, without their bodies
+    MemoryUsage indexMemoryUsage() const;
+
+    // Thread-safe, a consistent view for readers outside the GUI thread
+    std::shared_ptr<const CorpusSnapshot> snapshot() const;
+
+    // Snippets loaded so far, in browse mode those the scanners indexed
+    int snippetCount() const;
+
+    // Saves change what sorting by modification time or size compares. When set, they emit
+    // dataChanged() for the snippet so that it moves.
+    void setNotifiesSaves(bool);
 
 Q_SIGNALS:
     void loaded(int numSnippets, const QString &path);
+    void snapshotPublished(quint64 version);
 
 private:
+    // Each root is scanned by its own thread, so a slow one doesn't hold back the others
+    struct Root
+    {
+        QString path;
+        PathNode *node = nullptr;
+        QStandardItem *item = nullptr; // The invisible root item with a single root
+        SnippetIndex index;
+        bool opened = false; // Its SnippetStorage, by the scanner
+        QPointer<SnippetScanner> scanner;
+        QPointer<QThread> scanThread;
+    };
+
     QStandardItem *addSnippet(Snippet *, QStandardItem *parentItem);
-    QStandardItem *addFolder(const QString &name, const QString &absolutePath, QStandardItem *parentItem);
+    QStandardItem *addFolder(const QString &name, QStandardItem *parentItem);
+    QStandardItem *createSnippetItem(Snippet *);
+    QStandardItem *createFolderItem(const QString &name, const PathNode *parentNode);
+    QStandardItem *createRootItem(const Root *);
+    QStandardItem *parentFolderItem(const QModelIndex &parentIndex) const; // The first root for an invalid index
+    const PathNode *folderNode(const QStandardItem *folderItem) const;
+    Root *rootFor(const QString &absolutePath) const; // The innermost, like SnippetStorage::forPath()
+    bool isOpened(const PathNode *folder) const;
+    void startScanner(Root *);
+    void deleteSnippetsAndNodes();
+    void appendScannedFolder(const ScannedFolder &, QStandardItem *parentItem);
     QStandardItem *itemForName(const QString &name, const QModelIndex &parentIndex);
-    void import(QDir, QStandardItem *parentItem);
-    QString rootPath() const;
+    void onRootOpened(int generation, const QString &rootPath);
+    void onFolderScanned(const ScannedFolder &);
+    void onScanFinished(int generation, const QString &rootPath);
+    void cancelScan();
+    void notifyAncestors(QStandardItem *item);
 
     int m_numSnippets;
+    int m_loadGeneration = 0;
+    int m_pendingScans = 0;
+    bool m_notifySaves = false;
+    qint64 m_loadStart = 0; // For the trace
+    const bool m_browseMode;
+    QVector<Root *> m_roots;
+    QVector<PathNode *> m_folderNodes;
+    QHash<QString, QStandardItem *> m_scannedFolders; // Folders whose contents are still being scanned
+    CorpusPublisher m_publisher;
 };
 
 #endif
@@ -22,9 +22,14 @@
 
 #include "snippetproxymodel.h"
 #include "snippetmodel.h"
+#include "tracer.h"
 
 #include <QDebug>
-#include <QRegularExpression>
+#include <QTimer>
+
+enum {
+    PatternBudgetMs = 2000 // Per pass, for regex and glob terms
+};
 
 SnippetProxyModel::SnippetProxyModel(QObject *parent)
     : QSortFilterProxyModel(parent)
@@ -34,194 +39,732 @@ SnippetProxyModel::SnippetProxyModel(QObject *parent)
     connect(this, &SnippetProxyModel::modelReset, this, &SnippetProxyModel::countChanged);
     connect(this, &SnippetProxyModel::layoutChanged, this, &SnippetProxyModel::countChanged);
 
-    connect(this, &SnippetProxyModel::rowsRemoved, [this](const QModelIndex &parent, int, int) {
-        if (parent.isValid()) {
-            // The model that sits on top of this one filters out parents with no children
-            // So trigger it's filterAcceptsRow() to run
-            emit dataChanged(parent, parent);
-        }
-    });
+    // "Snippet 2" before "Snippet 10"
+    m_collator.setNumericMode(true);
+    m_collator.setCaseSensitivity(Qt::CaseInsensitive);
+}
 
-    connect(this, &SnippetProxyModel::rowsInserted, [this](const QModelIndex &parent, int, int) {
-        if (parent.isValid()) {
-            // The model that sits on top of this one filters out parents with no children
-            // So trigger it's filterAcceptsRow() to run
-            emit dataChanged(parent, parent);
-        }
-    });
+void SnippetProxyModel::setSourceModel(QAbstractItemModel *model)
+{
+    if (m_model) {
+        disconnect(m_model, nullptr, this, nullptr);
+        m_model->setNotifiesSaves(false);
+    }
+
+    m_model = qobject_cast<SnippetModel *>(model);
+    if (m_model) {
+        m_model->setNotifiesSaves(sortsBySaves());
+        // Connected before QSortFilterProxyModel's own handlers, so counts are up to date when it filters
+        connect(m_model, &QAbstractItemModel::rowsInserted, this, &SnippetProxyModel::onSourceRowsInserted);
+        connect(m_model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &SnippetProxyModel::onSourceRowsAboutToBeRemoved);
+        connect(m_model, &QAbstractItemModel::dataChanged, this, &SnippetProxyModel::onSourceDataChanged);
+        connect(m_model, &QAbstractItemModel::modelReset, this, &SnippetProxyModel::recomputeMatches);
+        connect(m_model, &QAbstractItemModel::modelReset, this, [this] {
+            m_titleKeys.clear();
+        });
+    }
+
+    m_titleKeys.clear();
+
+    QSortFilterProxyModel::setSourceModel(model);
+    recomputeMatches();
 }
 
 bool SnippetProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
 {
-    if (!sourceModel() || source_row < 0 || source_row >= sourceModel()->rowCount(source_parent))
+    if (!m_model || source_row < 0 || source_row >= m_model->rowCount(source_parent))
         return false;
 
     if (m_filterHasError)
         return false;
 
-    return accepts(sourceModel()->index(source_row, 0, source_parent));
+    if (!isFiltering())
+        return true;
+
+    const QStandardItem *item = m_model->itemFromIndex(m_model->index(source_row, 0, source_parent));
+    if (item->data(SnippetModel::IsFolderRole).toBool())
+        return m_folderCounts.contains(item);
+
+    return m_matchingSnippets.contains(item);
 }
 
-static QStringList tokensFromString(const QString &str)
+QVariant SnippetProxyModel::data(const QModelIndex &index, int role) const
 {
-    // Example:
-    // input: m_text is "a & b & (!c | d)"
-    // output: { "a", "b", "c", "d" }
+    if (role == SnippetModel::TitleMatchSpansRole) {
+        if (!isFiltering())
+            return QVariant();
+        return QVariant::fromValue(m_titleSpans.value(m_model->itemFromIndex(mapToSource(index))));
+    }
 
-    static QRegularExpression tokenSeparatorsRegex(R"(&|\||\(|\)|!| )");
-    return str.split(tokenSeparatorsRegex);
+    if (role == Qt::DisplayRole && isFiltering() && index.data(SnippetModel::IsFolderRole).toBool()) {
+        const Counts counts = m_folderCounts.value(m_model->itemFromIndex(mapToSource(index)));
+        const QString name = QSortFilterProxyModel::data(index, role).toString();
+        if (counts.unreadFolders > 0)
+            return QStringLiteral("%1 (%2+)").arg(name).arg(counts.snippets);
+
+        return QStringLiteral("%1 (%2)").arg(name).arg(counts.snippets);
+    }
+
+    return QSortFilterProxyModel::data(index, role);
 }
 
-static QString removeSpecialChars(const QString &token)
+QVector<const QStandardItem *> SnippetProxyModel::matchingSnippets() const
 {
-    QString result = token;
+    QVector<const QStandardItem *> snippets;
+    if (!m_model || m_filterHasError)
+        return snippets;
+
+    const bool filtering = isFiltering();
+    if (filtering)
+        snippets.reserve(m_matchingSnippets.size());
+
+    // Depth-first, only into folders with matches below them
+    QVector<const QStandardItem *> pending = { m_model->invisibleRootItem() };
+    while (!pending.isEmpty()) {
+        const QStandardItem *folder = pending.takeLast();
+        for (int row = folder->rowCount() - 1; row >= 0; --row) { // Reversed, so row 0 is next
+            const QStandardItem *child = folder->child(row);
+            if (!isFolderItem(child))
+                continue;
+            if (!filtering || m_folderCounts.value(child).snippets > 0)
+                pending.append(child);
+        }
 
-    if (!token.isEmpty() && token[0] == QLatin1Char(':'))
-        result.remove(0, 1);
+        for (int row = 0, count = folder->rowCount(); row < count; ++row) {
+            const QStandardItem *child = folder->child(row);
+            if (!isFolderItem(child) && (!filtering || m_matchingSnippets.contains(child)))
+                snippets.append(child);
+        }
+    }
 
-    return result;
+    return snippets;
 }
 
-static QString normalizeTextForJS(const QString &token)
+SnippetProxyModel::SortOrder SnippetProxyModel::sortOrder() const
 {
-    QString result = token;
-    // TODO: use regexp instead
-    result.replace(".", QString());
-    result.replace(":", QString());
-    result.replace("+", QString());
-    result.replace("-", QString());
-    return removeSpecialChars(result);
+    return m_sortOrder;
 }
 
-bool SnippetProxyModel::accepts(const QModelIndex &idx) const
+bool SnippetProxyModel::sortsBySaves() const
 {
-    if (m_text.isEmpty())
-        return true;
+    return m_sortOrder == ModifiedOrder || m_sortOrder == SizeOrder;
+}
 
-    QVector<bool> results;
-    results.reserve(m_searchTokens.size());
-    for (const QString &token : m_searchTokens) {
-        m_jsEngine.globalObject().setProperty(normalizeTextForJS(token), accepts(token, idx));
-    }
+void SnippetProxyModel::setSortOrder(SortOrder order)
+{
+    if (order == m_sortOrder)
+        return;
 
-    QJSValue result = m_jsEngine.evaluate(normalizeTextForJS(m_text));
+    SNIPPY_TRACE_ARGS("SnippetProxyModel::setSortOrder", QString::number(order));
+    m_sortOrder = order;
+    if (m_model)
+        m_model->setNotifiesSaves(sortsBySaves());
+    if (m_sortOrder == ScoreOrder)
+        recomputeMatches(); // Scores aren't kept up otherwise
+    else
+        m_scores.clear();
+
+    if (m_sortOrder == FolderOrder)
+        sort(-1);
+    else if (sortColumn() == 0)
+        invalidate(); // sort() would return early, same column and order
+    else
+        sort(0, Qt::AscendingOrder);
+
+    emit sortOrderChanged();
+}
 
-    if (result.isError()) {
-        qWarning() << "Filter has errors" << m_text << result.toString();
+bool SnippetProxyModel::snippetLessThan(const QStandardItem *left, const QStandardItem *right) const
+{
+    switch (m_sortOrder) {
+    case FolderOrder:
         return false;
-    } else {
-        return result.toBool();
+    case TitleOrder:
+        break;
+    case ModifiedOrder:
+    case SizeOrder: {
+        const Snippet *a = left->data(SnippetModel::SnippetRole).value<Snippet *>();
+        const Snippet *b = right->data(SnippetModel::SnippetRole).value<Snippet *>();
+        const qint64 valueA = m_sortOrder == ModifiedOrder ? a->modified() : a->size();
+        const qint64 valueB = m_sortOrder == ModifiedOrder ? b->modified() : b->size();
+        if (valueA != valueB)
+            return valueA > valueB;
+        break;
+    }
+    case ScoreOrder: {
+        const int scoreA = m_scores.value(left);
+        const int scoreB = m_scores.value(right);
+        if (scoreA != scoreB)
+            return scoreA > scoreB;
+        break;
     }
+    }
+
+    return titleKey(left).compare(titleKey(right)) < 0;
 }
 
-bool SnippetProxyModel::accepts(const QString &searchToken, const QModelIndex &idx) const
+bool SnippetProxyModel::lessThan(const QModelIndex &source_left, const QModelIndex &source_right) const
 {
-    if (searchToken.isEmpty())
-        return true;
+    const QStandardItem *left = m_model->itemFromIndex(source_left);
+    const QStandardItem *right = m_model->itemFromIndex(source_right);
+    const bool leftIsFolder = isFolderItem(left);
+    if (leftIsFolder != isFolderItem(right))
+        return leftIsFolder;
+
+    if (leftIsFolder)
+        return titleKey(left).compare(titleKey(right)) < 0;
+
+    return snippetLessThan(left, right);
+}
+
+QCollatorSortKey SnippetProxyModel::titleKey(const QStandardItem *item) const
+{
+    // By value, inserting another key can rehash. The key is implicitly shared.
+    auto it = m_titleKeys.constFind(item);
+    if (it != m_titleKeys.cend())
+        return it.value();
+
+    const QString title = m_model->data(item->index(), Qt::DisplayRole).toString(); // A folder's name for folders
+    return m_titleKeys.insert(item, m_collator.sortKey(title)).value();
+}
 
-    QString filterText = removeSpecialChars(searchToken);
-    const bool foldersOnly = searchToken.startsWith(':');
+void SnippetProxyModel::forgetTitleKeys(const QStandardItem *item)
+{
+    QVector<const QStandardItem *> pending = { item };
+    while (!pending.isEmpty()) {
+        const QStandardItem *current = pending.takeLast();
+        m_titleKeys.remove(current);
+        for (int row = 0, count = current->rowCount(); row < count; ++row)
+            pending.append(current->child(row));
+    }
+}
 
-    filterText.replace(QRegularExpression("\\/*$"), QString()); // Remove trailling slash
-    filterText.replace(QRegularExpression("\\\\*$"), QString()); // Remove trailling back-slash
+int SnippetProxyModel::score(const Snippet *snippet, const QString &folderPath) const
+{
+    // Bodies aren't decoded for this, they can only tell which snippets match
+    enum {
+        TitleWeight = 4,
+        TitleStartWeight = 2, // On top of TitleWeight
+        TagWeight = 2,
+        PathWeight = 1
+    };
+
+    int score = 0;
+    const QString title = snippet->title();
+    foreach (const FilterQuery::Term &term, m_positiveTerms) {
+        const bool any = term.field == FilterQuery::AnyField;
+        if ((any || term.field == FilterQuery::TitleField) && term.matches(title)) {
+            score += TitleWeight;
+            if (!term.isPattern() && title.startsWith(term.text, Qt::CaseInsensitive))
+                score += TitleStartWeight;
+        }
 
-    QModelIndex parent = idx.parent();
-    const bool isFolder = idx.data(SnippetModel::IsFolderRole).toBool();
+        if ((any || term.field == FilterQuery::TagField) && snippet->tagSet().intersects(tagsMatching(term)))
+            score += TagWeight;
 
-    if (parent.isValid()) {
-        const QString absolutePath = parent.data(SnippetModel::RelativePathRole).toString();
-        if (absolutePath.contains(filterText, Qt::CaseInsensitive))
-            return true;
+        if ((any || term.field == FilterQuery::PathField || term.field == FilterQuery::FolderField)
+            && !folderPath.isEmpty() && term.matches(folderPath))
+            score += PathWeight;
     }
 
-    const QString title = idx.data(Qt::DisplayRole).toString();
+    return score;
+}
+
+int SnippetProxyModel::matchCount(const QModelIndex &sourceFolder) const
+{
+    return m_model ? m_folderCounts.value(m_model->itemFromIndex(sourceFolder)).snippets : 0;
+}
 
-    if (foldersOnly && (!isFolder && title != SnippetModel::emptySnippetTitle()))
+TagSet SnippetProxyModel::requiredTags() const
+{
+    return m_requiredTags;
+}
+
+void SnippetProxyModel::setRequiredTags(const TagSet &tags)
+{
+    if (tags == m_requiredTags)
+        return;
+
+    const bool hasCandidates = isFiltering() && !m_filterHasError;
+    m_requiredTags = tags;
+
+    if (hasCandidates && isFiltering())
+        rebuildMatchesFromCandidates();
+    else
+        recomputeMatches();
+
+    invalidateFilter();
+    emit requiredTagsChanged();
+}
+
+bool SnippetProxyModel::isFiltering() const
+{
+    return !m_text.isEmpty() || !m_requiredTags.isEmpty();
+}
+
+int SnippetProxyModel::matchingTagCount(int tagId) const
+{
+    if (!isFiltering())
+        return TagDictionary::instance().usageCount(tagId);
+
+    return m_matchingTagCounts.value(tagId);
+}
+
+MemoryUsage SnippetProxyModel::memoryUsage() const
+{
+    enum {
+        HashNodeBytes = 2 * int(sizeof(void *)) + int(sizeof(uint)) // next, key and hash
+    };
+
+    MemoryUsage usage;
+    usage.objects = m_candidates.size() + m_matchingSnippets.size() + m_unreadMatches.size() + m_folderCounts.size()
+                    + m_titleSpans.size() + m_scores.size() + m_titleKeys.size();
+    for (const TagSet &tags : m_candidates)
+        usage.bytes += HashNodeBytes + tags.memoryUsage();
+    usage.bytes += (m_matchingSnippets.size() + m_unreadMatches.size()) * qint64(HashNodeBytes);
+    usage.bytes += m_folderCounts.size() * qint64(HashNodeBytes + sizeof(Counts));
+    usage.bytes += m_matchingTagCounts.capacity() * qint64(sizeof(int));
+    usage.bytes += m_scores.size() * qint64(HashNodeBytes + sizeof(int));
+    usage.bytes += m_titleKeys.size() * qint64(HashNodeBytes + sizeof(QCollatorSortKey)); // Key bytes are opaque
+    for (const QVector<MatchSpan> &spans : m_titleSpans)
+        usage.bytes += HashNodeBytes + spans.capacity() * qint64(sizeof(MatchSpan));
+    for (auto it = m_tagsByToken.cbegin(), end = m_tagsByToken.cend(); it != end; ++it)
+        usage.bytes += HashNodeBytes + MemoryStats::stringBytes(it.key()) + it.value().memoryUsage();
+
+    return usage;
+}
+
+void SnippetProxyModel::recomputeMatches()
+{
+    SNIPPY_TRACE_ARGS("SnippetProxyModel::recomputeMatches", m_text);
+    m_candidates.clear();
+    m_titleSpans.clear();
+    m_scores.clear();
+    m_matchingSnippets.clear();
+    m_unreadMatches.clear();
+    m_folderCounts.clear();
+    m_matchingTagCounts.fill(0);
+
+    if (m_model && isFiltering() && !m_filterHasError) {
+        // Planned again on every pass, the tag counts change as snippets load
+        FilterQuery::Statistics statistics;
+        statistics.snippetCount = m_model->snippetCount();
+        statistics.deepSearch = m_deepSearch;
+        statistics.tagUsage = [this](const FilterQuery::Term &term) {
+            int usage = 0;
+            for (int id : tagsMatching(term).ids())
+                usage += TagDictionary::instance().usageCount(id);
+            return usage;
+        };
+        m_query.plan(statistics);
+        m_query.resetStatistics();
+
+        m_query.startPass(PatternBudgetMs);
+        evaluateSubtree(m_model->invisibleRootItem());
+        checkPatternBudget();
+    }
+
+    emit matchingTagCountsChanged();
+    emit matchesChanged();
+}
+
+void SnippetProxyModel::rebuildMatchesFromCandidates()
+{
+    SNIPPY_TRACE("SnippetProxyModel::rebuildMatchesFromCandidates");
+    m_matchingSnippets.clear();
+    m_folderCounts.clear();
+    m_matchingTagCounts.fill(0);
+
+    for (auto it = m_candidates.cbegin(), end = m_candidates.cend(); it != end; ++it) {
+        if (addMatch(it.key(), it.value()))
+            addToAncestors(it.key(), 1, 0);
+    }
+
+    foreach (const QStandardItem *folder, m_unreadMatches) {
+        m_folderCounts[folder].unreadFolders++;
+        addToAncestors(folder, 0, 1);
+    }
+
+    emit matchingTagCountsChanged();
+    emit matchesChanged();
+}
+
+bool SnippetProxyModel::addMatch(const QStandardItem *item, const TagSet &tags)
+{
+    if (!tags.contains(m_requiredTags))
         return false;
 
-    if (title.contains(filterText, Qt::CaseInsensitive))
-        return true;
+    m_matchingSnippets.insert(item);
+    for (int id : tags.ids()) {
+        if (id >= m_matchingTagCounts.size())
+            m_matchingTagCounts.resize(id + 1);
+        m_matchingTagCounts[id]++;
+    }
 
-    if (isFolder) {
-        const int numChildren = sourceModel()->rowCount(idx);
-        for (int i = 0; i < numChildren; ++i) {
-            if (accepts(searchToken, sourceModel()->index(i, 0, idx)))
-                return true;
-        }
-    } else {
-        Snippet *snippet = idx.data(SnippetModel::SnippetRole).value<Snippet *>();
-        if (title == SnippetModel::emptySnippetTitle())
-            return true;
-
-        foreach (const QString &tag, snippet->tags()) {
-            if (tag.contains(filterText, Qt::CaseInsensitive))
-                return true;
+    return true;
+}
+
+bool SnippetProxyModel::removeMatch(const QStandardItem *item, const TagSet &tags)
+{
+    if (!m_matchingSnippets.remove(item))
+        return false;
+
+    for (int id : tags.ids())
+        m_matchingTagCounts[id]--;
+
+    return true;
+}
+
+bool SnippetProxyModel::isFolderItem(const QStandardItem *item) const
+{
+    return item == m_model->invisibleRootItem() || item->data(SnippetModel::IsFolderRole).toBool();
+}
+
+SnippetProxyModel::Counts SnippetProxyModel::evaluateSnippet(const QStandardItem *item)
+{
+    Counts counts;
+    if (!m_text.isEmpty() && !accepts(item->index()))
+        return counts;
+
+    const Snippet *snippet = item->data(SnippetModel::SnippetRole).value<Snippet *>();
+    const TagSet tags = snippet->tagSet();
+    m_candidates.insert(item, tags);
+    if (addMatch(item, tags))
+        counts.snippets = 1;
+
+    if (!m_titleTerms.isEmpty()) {
+        // Titles are short, all positive terms are looked for, not just those evaluated
+        const QVector<MatchSpan> spans = FilterQuery::matchSpans(m_titleTerms, snippet->title());
+        if (!spans.isEmpty())
+            m_titleSpans.insert(item, spans);
+    }
+
+    if (m_sortOrder == ScoreOrder) {
+        // Like accepts(), paths are those of the folder, file names tell nothing
+        const QStandardItem *parent = item->parent();
+        const QString folderPath = parent ? m_model->data(parent->index(), SnippetModel::RelativePathRole).toString()
+                                          : QString();
+        m_scores.insert(item, score(snippet, folderPath));
+    }
+
+    return counts;
+}
+
+SnippetProxyModel::Counts SnippetProxyModel::evaluateUnreadFolder(const QStandardItem *folder)
+{
+    // Browse mode, the index answers for what's below. It only knows about text.
+    Counts counts;
+    if (folder != m_model->invisibleRootItem() && folder->data(SnippetModel::NeedsFetchRole).toBool()
+        && !m_text.isEmpty() && accepts(folder->index())) {
+        m_unreadMatches.insert(folder);
+        counts.unreadFolders = 1;
+    }
+
+    return counts;
+}
+
+SnippetProxyModel::Counts SnippetProxyModel::evaluateSubtree(const QStandardItem *item)
+{
+    if (!isFolderItem(item))
+        return evaluateSnippet(item);
+
+    // Post-order without recursion, so deep trees don't overflow the stack
+    struct Frame
+    {
+        const QStandardItem *folder;
+        int nextRow;
+        Counts counts;
+    };
+
+    QVector<Frame> stack = { { item, 0, evaluateUnreadFolder(item) } };
+    while (true) {
+        Frame &frame = stack.last();
+        if (frame.nextRow < frame.folder->rowCount()) {
+            const QStandardItem *child = frame.folder->child(frame.nextRow++);
+            if (isFolderItem(child))
+                stack.append({ child, 0, evaluateUnreadFolder(child) }); // frame is dangling from here on
+            else
+                frame.counts += evaluateSnippet(child);
+            continue;
         }
 
-        if (m_deepSearch) {
-            if (snippet->contents().contains(filterText, Qt::CaseInsensitive))
-                return true;
+        const Frame done = stack.takeLast();
+        if (done.counts.isEmpty())
+            m_folderCounts.remove(done.folder);
+        else
+            m_folderCounts.insert(done.folder, done.counts);
+
+        if (stack.isEmpty())
+            return done.counts;
+
+        stack.last().counts += done.counts;
+    }
+}
+
+SnippetProxyModel::Counts SnippetProxyModel::forgetSubtree(const QStandardItem *item)
+{
+    Counts counts;
+    auto it = m_candidates.find(item);
+    if (it != m_candidates.end()) {
+        if (removeMatch(item, it.value()))
+            counts.snippets = 1;
+        m_candidates.erase(it);
+        m_titleSpans.remove(item);
+        m_scores.remove(item);
+        return counts;
+    }
+
+    // The folder's own counts already cover everything below it, nothing to add up
+    counts = m_folderCounts.value(item);
+    QVector<const QStandardItem *> pending = { item };
+    while (!pending.isEmpty()) {
+        const QStandardItem *folder = pending.takeLast();
+        m_folderCounts.remove(folder);
+        m_unreadMatches.remove(folder);
+        for (int row = 0, count = folder->rowCount(); row < count; ++row) {
+            const QStandardItem *child = folder->child(row);
+            auto childIt = m_candidates.find(child);
+            if (childIt != m_candidates.end()) {
+                removeMatch(child, childIt.value());
+                m_candidates.erase(childIt);
+                m_titleSpans.remove(child);
+                m_scores.remove(child);
+            } else {
+                pending.append(child);
+            }
         }
     }
 
-    return false;
+    return counts;
 }
 
-bool SnippetProxyModel::isDeepSearch() const
+void SnippetProxyModel::addToAncestors(const QStandardItem *item, int snippetsDelta, int unreadFoldersDelta)
 {
-    return m_deepSearch;
+    if (!item || (snippetsDelta == 0 && unreadFoldersDelta == 0))
+        return;
+
+    for (const QStandardItem *ancestor = item->parent(); ancestor; ancestor = ancestor->parent()) {
+        Counts &counts = m_folderCounts[ancestor];
+        counts.snippets += snippetsDelta;
+        counts.unreadFolders += unreadFoldersDelta;
+        if (counts.isEmpty())
+            m_folderCounts.remove(ancestor);
+    }
 }
 
-void SnippetProxyModel::setIsDeepSearch(bool is)
+void SnippetProxyModel::onSourceRowsInserted(const QModelIndex &parent, int first, int last)
 {
-    if (is != m_deepSearch) {
-        m_deepSearch = is;
-        invalidateFilter();
+    if (!isFiltering() || m_filterHasError)
+        return;
+
+    // The rows share their ancestors, walk up once for all of them
+    Counts counts;
+    const QStandardItem *item = nullptr;
+    m_query.startPass(PatternBudgetMs);
+    for (int row = first; row <= last; ++row) {
+        item = m_model->itemFromIndex(m_model->index(row, 0, parent));
+        counts += evaluateSubtree(item);
     }
+    addToAncestors(item, counts.snippets, counts.unreadFolders);
+    checkPatternBudget();
+
+    emit matchingTagCountsChanged();
+    emit matchesChanged();
 }
 
-void SnippetProxyModel::verifyExpressionValidity()
+void SnippetProxyModel::onSourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
 {
-    if (m_text.isEmpty()) {
-        setFilterHasError(false);
+    if (!m_titleKeys.isEmpty()) {
+        for (int row = first; row <= last; ++row)
+            forgetTitleKeys(m_model->itemFromIndex(m_model->index(row, 0, parent)));
+    }
+
+    if (!isFiltering() || m_filterHasError)
         return;
+
+    Counts counts;
+    const QStandardItem *item = nullptr;
+    for (int row = first; row <= last; ++row) {
+        item = m_model->itemFromIndex(m_model->index(row, 0, parent));
+        counts += forgetSubtree(item);
+    }
+    addToAncestors(item, -counts.snippets, -counts.unreadFolders);
+
+    emit matchingTagCountsChanged();
+    emit matchesChanged();
+}
+
+void SnippetProxyModel::onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+{
+    // Before QSortFilterProxyModel gets to re-sort the rows, a title or a folder name might have changed
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row)
+        m_titleKeys.remove(m_model->itemFromIndex(topLeft.sibling(row, 0)));
+
+    if (!isFiltering() || m_filterHasError)
+        return;
+
+    m_query.startPass(PatternBudgetMs);
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        const QStandardItem *item = m_model->itemFromIndex(topLeft.sibling(row, 0));
+        if (item->data(SnippetModel::IsFolderRole).toBool()) {
+            // Folders also get a role-less dataChanged when their contents change, counts are
+            // already correct then. A rename or a fetch does change what's below though.
+            if (!roles.contains(SnippetModel::FolderNameRole) && !roles.contains(SnippetModel::NeedsFetchRole))
+                continue;
+        }
+
+        const Counts before = forgetSubtree(item);
+        const Counts after = evaluateSubtree(item);
+        addToAncestors(item, after.snippets - before.snippets, after.unreadFolders - before.unreadFolders);
     }
+    checkPatternBudget();
 
-    // Do an evaluation with dummy values just to verify syntax,
-    // so that UI can make the line edit red
+    emit matchingTagCountsChanged();
+    emit matchesChanged();
+}
 
-    QJSEngine engine;
-    bool canEvaluate = false;
-    for (const QString &token : m_searchTokens) {
-        QString normalizedToken = normalizeTextForJS(token);
-        if (!normalizedToken.isEmpty()) {
-            engine.globalObject().setProperty(normalizedToken, true);
-            canEvaluate = true;
+bool SnippetProxyModel::accepts(const QModelIndex &idx) const
+{
+    return m_query.matches([this, &idx](const FilterQuery::Term &term) {
+        return accepts(term, idx);
+    });
+}
+
+bool SnippetProxyModel::accepts(const FilterQuery::Term &term, const QModelIndex &idx) const
+{
+    const QString title = idx.data(Qt::DisplayRole).toString();
+    auto parentPathMatches = [&idx, &term] {
+        const QModelIndex parent = idx.parent();
+        return parent.isValid() && term.matches(parent.data(SnippetModel::RelativePathRole).toString());
+    };
+
+    if (idx.data(SnippetModel::IsFolderRole).toBool()) {
+        // Only asked for folders that weren't read yet (browse mode), otherwise folders
+        // are accepted based on the snippets below them. The index has no bodies and
+        // doesn't tell titles, tags and paths apart, so this is a maybe.
+        const bool pathMatches = parentPathMatches() || term.matches(title);
+        const bool canFetch = m_model->canFetchMore(idx);
+        switch (term.field) {
+        case FilterQuery::AnyField:
+            return pathMatches || (canFetch && m_model->indexMatches(idx, term, /*foldersOnly=*/false));
+        case FilterQuery::PathField:
+        case FilterQuery::FolderField:
+            return pathMatches || (canFetch && m_model->indexMatches(idx, term, /*foldersOnly=*/true));
+        case FilterQuery::TitleField:
+        case FilterQuery::TagField:
+            return canFetch && m_model->indexMatches(idx, term, /*foldersOnly=*/false);
+        case FilterQuery::BodyField:
+            return false;
         }
+
+        return false;
     }
 
-    if (canEvaluate) {
-        QJSValue result = engine.evaluate(normalizeTextForJS(m_text));
-        setFilterHasError(result.isError());
-    } else {
-        setFilterHasError(true);
+    // Snippets that were just created have no title yet, they stay visible so they can be edited
+    if (title == SnippetModel::emptySnippetTitle())
+        return true;
+
+    Snippet *snippet = idx.data(SnippetModel::SnippetRole).value<Snippet *>();
+    switch (term.field) {
+    case FilterQuery::AnyField:
+        return parentPathMatches() || term.matches(title) || snippet->tagSet().intersects(tagsMatching(term))
+               || (m_deepSearch && bodyMatches(snippet, term));
+    case FilterQuery::TitleField:
+        return term.matches(title);
+    case FilterQuery::TagField:
+        return snippet->tagSet().intersects(tagsMatching(term));
+    case FilterQuery::PathField:
+    case FilterQuery::FolderField:
+        return parentPathMatches();
+    case FilterQuery::BodyField:
+        return bodyMatches(snippet, term);
+    }
+
+    return false;
+}
+
+bool SnippetProxyModel::bodyMatches(const Snippet *snippet, const FilterQuery::Term &term)
+{
+    return term.isPattern() ? snippet->contentsMatch(term.pattern) : snippet->contentsContain(term.text);
+}
+
+const TagSet &SnippetProxyModel::tagsMatching(const FilterQuery::Term &term) const
+{
+    const TagDictionary &dictionary = TagDictionary::instance();
+    if (m_tagsByTokenDictionarySize != dictionary.count()) {
+        // Snippets loaded since the query was resolved brought new tags
+        m_tagsByToken.clear();
+        m_tagsByTokenDictionarySize = dictionary.count();
+    }
+
+    // Patterns are keyed apart from plain text, "a.c" is a different question for each
+    const QString key = term.isPattern() ? QLatin1Char('/') + term.pattern.pattern() : term.text;
+    auto it = m_tagsByToken.find(key);
+    if (it != m_tagsByToken.end())
+        return it.value();
+
+    if (!term.isPattern())
+        return m_tagsByToken.insert(key, dictionary.matching(term.text)).value();
+
+    // The trie only answers substrings, patterns go through every tag once per query
+    TagSet tags;
+    for (int id = 0, count = dictionary.count(); id < count; ++id) {
+        if (term.matches(dictionary.tag(id)))
+            tags.insert(id);
+    }
+
+    return m_tagsByToken.insert(key, tags).value();
+}
+
+void SnippetProxyModel::refresh()
+{
+    if (isFiltering()) {
+        recomputeMatches();
+        invalidateMatches();
+    }
+}
+
+bool SnippetProxyModel::isDeepSearch() const
+{
+    return m_deepSearch;
+}
+
+void SnippetProxyModel::setIsDeepSearch(bool is)
+{
+    if (is != m_deepSearch) {
+        m_deepSearch = is;
+        recomputeMatches();
+        invalidateMatches();
     }
 }
 
 void SnippetProxyModel::setFilterText(QString text)
 {
-    text = text.toLower();
+    text = text.trimmed(); // Not lower-cased, regexes can have \S and \s
     if (text != m_text) {
         m_text = text;
-        m_searchTokens = tokensFromString(m_text);
-
-        for (const QString &token : m_searchTokens)
-            m_jsEngine.globalObject().deleteProperty(token);
+        m_query = FilterQuery(m_text);
+        m_query.setTimingEnabled(m_explaining);
+        m_tagsByToken.clear();
+
+        // What gets highlighted, tags and paths don't show up in titles or bodies
+        m_titleTerms.clear();
+        m_bodyTerms.clear();
+        m_positiveTerms = m_query.positiveTerms();
+        foreach (const FilterQuery::Term &term, m_positiveTerms) {
+            if (term.field == FilterQuery::AnyField || term.field == FilterQuery::TitleField)
+                m_titleTerms.append(term);
+            if (term.field == FilterQuery::AnyField || term.field == FilterQuery::BodyField)
+                m_bodyTerms.append(term);
+        }
 
-        verifyExpressionValidity();
+        setFilterHasError(!m_query.isValid());
+        if (m_filterHasError)
+            qDebug() << "Filter has errors" << m_text << m_query.errorString();
 
         if (!m_filterHasError) {
-            invalidateFilter();
+            recomputeMatches();
+            invalidateMatches();
             filterTextChanged(m_text);
         }
     }
@@ -232,9 +775,52 @@ bool SnippetProxyModel::filterHasError() const
     return m_filterHasError;
 }
 
-QStringList SnippetProxyModel::searchTokens() const
+QVector<MatchSpan> SnippetProxyModel::bodyMatchSpans(const Snippet *snippet) const
+{
+    if (!snippet || m_bodyTerms.isEmpty())
+        return {};
+
+    return FilterQuery::matchSpans(m_bodyTerms, snippet->contents());
+}
+
+QString SnippetProxyModel::explainFilter() const
+{
+    return m_query.explain();
+}
+
+void SnippetProxyModel::setExplaining(bool explaining)
+{
+    if (explaining == m_explaining)
+        return;
+
+    m_explaining = explaining;
+    m_query.setTimingEnabled(explaining);
+    if (explaining)
+        refresh(); // So that the first report has timings
+}
+
+void SnippetProxyModel::checkPatternBudget()
 {
-    return m_searchTokens;
+    if (!m_query.timedOut())
+        return;
+
+    // Shown like a syntax error, rather than as a partial result that looks complete
+    qWarning() << Q_FUNC_INFO << "Patterns in" << m_text << "took longer than" << PatternBudgetMs << "ms, giving up";
+    setFilterHasError(true);
+
+    // Not right away, this can run within the source model's signals
+    QTimer::singleShot(0, this, [this] {
+        invalidateFilter();
+    });
+}
+
+void SnippetProxyModel::invalidateMatches()
+{
+    // Scores changed along with what matches, the kept rows need sorting again
+    if (m_sortOrder == ScoreOrder)
+        invalidate();
+    else
+        invalidateFilter();
 }
 
 void SnippetProxyModel::setFilterHasError(bool has)
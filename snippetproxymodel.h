@@ -23,42 +23,171 @@
 #ifndef SNIPPY_SNIPPET_PROXY_MODEL_H
 #define SNIPPY_SNIPPET_PROXY_MODEL_H
 
+#include "filterquery.h"
+#include "tagdictionary.h"
+
 #include <QSortFilterProxyModel>
-#include <QJSEngine>
+#include <QCollator>
+#include <QHash>
+#include <QSet>
+
+class Snippet;
+class SnippetModel;
+class QStandardItem;
+
+// Filters snippets by the line edit's expression and hides folders with nothing matching.
+// Per-folder match counts are kept up to date as rows come and go, instead of asking
+// each folder's children on every filterAcceptsRow().
+// Can also sort, title comparisons use collation keys computed once per title.
 
 class SnippetProxyModel : public QSortFilterProxyModel
 {
     Q_OBJECT
 public:
+    enum SortOrder {
+        FolderOrder = 0, // As stored, not sorted
+        TitleOrder,
+        ModifiedOrder, // Newest first
+        SizeOrder, // Largest first
+        ScoreOrder // Best match first, by title then tags then path
+    };
+
     explicit SnippetProxyModel(QObject *parent = nullptr);
+    void setSourceModel(QAbstractItemModel *) override;
     bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
     bool isDeepSearch() const;
     void setIsDeepSearch(bool);
     void setFilterText(QString);
     bool filterHasError() const;
 
-    QStringList searchTokens() const;
+    // Where the filter's terms are in the body, computed when asked as bodies aren't decoded
+    // while filtering. Titles have theirs recorded by the filter pass, see TitleMatchSpansRole.
+    QVector<MatchSpan> bodyMatchSpans(const Snippet *) const;
+
+    // The current filter's plan, with what each term matched during the last pass and, while
+    // explaining, what it cost. Timing terms slows filtering down, so it's only on meanwhile.
+    QString explainFilter() const;
+    void setExplaining(bool);
+
+    // Re-runs the current filter, for when the model learned something new
+    void refresh();
+
+    // Matching snippets of the source model, every snippet if no filter is set. Walks only
+    // the folders with matches, a folder's snippets come before its sub-folders'.
+    QVector<const QStandardItem *> matchingSnippets() const;
+
+    // Number of matching snippets below a folder, 0 if no filter is set
+    int matchCount(const QModelIndex &sourceFolder) const;
+
+    // Only snippets having all of these tags pass. Narrowing or widening this only
+    // intersects the snippets that passed the text filter, the tree isn't walked again.
+    TagSet requiredTags() const;
+    void setRequiredTags(const TagSet &);
+
+    // True if there's filter text or required tags
+    bool isFiltering() const;
+
+    // Number of snippets passing the filter that have this tag
+    int matchingTagCount(int tagId) const;
+
+    // Folders always come first, sorted by name. Rows inserted later are placed by
+    // binary search, the rest of the tree isn't sorted again.
+    SortOrder sortOrder() const;
+    void setSortOrder(SortOrder);
+
+    // Snippet items of the source model, as the current sort order has them. False for
+    // both ways in FolderOrder, for callers doing a stable sort.
+    bool snippetLessThan(const QStandardItem *left, const QStandardItem *right) const;
+
+    // The match bookkeeping
+    MemoryUsage memoryUsage() const;
 
 Q_SIGNALS:
     void filterTextChanged(const QString &text);
     void countChanged();
     void filterHasErrorChanged(bool);
+    void requiredTagsChanged();
+    void matchingTagCountsChanged();
+    void matchesChanged();
+    void sortOrderChanged();
+
+protected:
+    bool lessThan(const QModelIndex &source_left, const QModelIndex &source_right) const override;
 
 private:
-    void verifyExpressionValidity();
+    struct Counts
+    {
+        int snippets = 0;
+        int unreadFolders = 0; // Browse mode: matching folders whose contents weren't read yet
+
+        bool isEmpty() const
+        {
+            return snippets == 0 && unreadFolders == 0;
+        }
+
+        Counts &operator+=(const Counts &other)
+        {
+            snippets += other.snippets;
+            unreadFolders += other.unreadFolders;
+            return *this;
+        }
+    };
+
     void setFilterHasError(bool);
+    void invalidateMatches(); // invalidateFilter(), or a full invalidate() if scores sort
+    bool sortsBySaves() const; // Modification time or size, which saves change
+    QCollatorSortKey titleKey(const QStandardItem *) const;
+    void forgetTitleKeys(const QStandardItem *); // And those below
+    int score(const Snippet *, const QString &folderPath) const;
+    void checkPatternBudget();
     // Checks if we accept the row, given the line edit filter text, like: "foo & bar"
     bool accepts(const QModelIndex &idx) const;
 
-    // Checks if we accept the row, given a single search token, like "foo".
-    bool accepts(const QString &token, const QModelIndex &idx) const;
+    // Checks if we accept the row, given a single term, like "foo" or "tag:bar"
+    bool accepts(const FilterQuery::Term &term, const QModelIndex &idx) const;
+
+    // Resolved once per query (and when new tags show up), then tested with bit operations
+    const TagSet &tagsMatching(const FilterQuery::Term &) const;
+    static bool bodyMatches(const Snippet *, const FilterQuery::Term &);
+
+    void recomputeMatches();
+    void rebuildMatchesFromCandidates();
+    bool addMatch(const QStandardItem *, const TagSet &tags);
+    bool removeMatch(const QStandardItem *, const TagSet &tags);
+    bool isFolderItem(const QStandardItem *) const; // The invisible root counts as one
+    Counts evaluateSnippet(const QStandardItem *);
+    Counts evaluateUnreadFolder(const QStandardItem *);
+    Counts evaluateSubtree(const QStandardItem *);
+    Counts forgetSubtree(const QStandardItem *);
+    void addToAncestors(const QStandardItem *, int snippetsDelta, int unreadFoldersDelta);
+    void onSourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void onSourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
 
+    SnippetModel *m_model = nullptr;
     bool m_deepSearch = false;
+    bool m_explaining = false;
     QString m_text;
-    QStringList m_searchTokens;
-    mutable QJSEngine m_jsEngine;
+    FilterQuery m_query;
     bool m_filterHasError = false;
+    TagSet m_requiredTags;
+    QHash<const QStandardItem *, TagSet> m_candidates; // Snippets passing the text filter, with their tags
+    QHash<const QStandardItem *, QVector<MatchSpan>> m_titleSpans; // Candidates with a highlighted title
+    QVector<FilterQuery::Term> m_titleTerms;
+    QVector<FilterQuery::Term> m_bodyTerms;
+    QVector<FilterQuery::Term> m_positiveTerms; // What scores are made of
+    QHash<const QStandardItem *, int> m_scores; // Candidates, only while in ScoreOrder
+    QSet<const QStandardItem *> m_matchingSnippets; // Candidates that also have the required tags
+    QSet<const QStandardItem *> m_unreadMatches; // Browse mode, unread folders the index says match
+    QHash<const QStandardItem *, Counts> m_folderCounts; // Only non-empty ones
+    QVector<int> m_matchingTagCounts; // Indexed by tag id
+    mutable QHash<QString, TagSet> m_tagsByToken;
+    mutable int m_tagsByTokenDictionarySize = 0;
+    SortOrder m_sortOrder = FolderOrder;
+    QCollator m_collator;
+    mutable QHash<const QStandardItem *, QCollatorSortKey> m_titleKeys; // Filled as sorting asks
 };
 
 #endif
@@ -0,0 +1,109 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "snippetscanner.h"
+#include "snippetstorage.h"
+#include "tracer.h"
+
+#include <QQueue>
+
+enum {
+    ChunkSize = 200 // snippets per published chunk
+};
+
+SnippetScanner::SnippetScanner(const QString &rootPath, int generation, bool headersOnly, QObject *parent)
+    : QObject(parent)
+    , m_rootPath(rootPath)
+    , m_generation(generation)
+    , m_headersOnly(headersOnly)
+    , m_cancelled(false)
+{
+    qRegisterMetaType<ScannedFolder>("ScannedFolder");
+}
+
+void SnippetScanner::run()
+{
+    Tracer::setThreadName(QStringLiteral("scanner"));
+    SNIPPY_TRACE_ARGS("SnippetScanner::run", m_rootPath);
+
+    // Breadth-first, so the top-level folders show up first
+    QQueue<QString> pendingFolders;
+    pendingFolders.enqueue(m_rootPath);
+
+    SnippetStorage *storage = SnippetStorage::open(m_rootPath);
+    emit opened(m_generation, m_rootPath);
+    while (!pendingFolders.isEmpty() && !m_cancelled) {
+        ScannedFolder chunk;
+        chunk.generation = m_generation;
+        chunk.absolutePath = pendingFolders.dequeue();
+
+        QStringList snippetNames;
+        QStringList subFolders;
+        storage->list(chunk.absolutePath, snippetNames, subFolders);
+        foreach (const QString &filename, snippetNames) {
+            if (m_cancelled)
+                break;
+
+            SnippetData data;
+            storage->read(chunk.absolutePath + QLatin1Char('/') + filename, data, m_headersOnly);
+            chunk.snippets.append(data);
+
+            if (chunk.snippets.size() >= ChunkSize) {
+                emit folderScanned(chunk);
+                chunk.snippets.clear();
+            }
+        }
+
+        chunk.subFolders = subFolders; // Only in the last chunk
+        foreach (const QString &foldername, chunk.subFolders)
+            pendingFolders.enqueue(chunk.absolutePath + QLatin1Char('/') + foldername);
+
+        if (!chunk.snippets.isEmpty() || !chunk.subFolders.isEmpty())
+            emit folderScanned(chunk);
+    }
+
+    emit finished(m_generation, m_rootPath);
+}
+
+/*static*/
+ScannedFolder SnippetScanner::scanFolder(const QString &absolutePath, bool headersOnly)
+{
+    SNIPPY_TRACE_ARGS("SnippetScanner::scanFolder", absolutePath);
+    ScannedFolder folder;
+    folder.absolutePath = absolutePath;
+
+    SnippetStorage *storage = SnippetStorage::forPath(absolutePath);
+    QStringList snippetNames;
+    storage->list(absolutePath, snippetNames, folder.subFolders);
+    foreach (const QString &filename, snippetNames) {
+        SnippetData data;
+        storage->read(absolutePath + QLatin1Char('/') + filename, data, headersOnly);
+        folder.snippets.append(data);
+    }
+
+    return folder;
+}
+
+void SnippetScanner::cancel()
+{
+    m_cancelled = true;
+}
@@ -0,0 +1,77 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_SNIPPET_SCANNER_H
+#define SNIPPY_SNIPPET_SCANNER_H
+
+#include "snippet.h"
+
+#include <QObject>
+#include <QVector>
+#include <QMetaType>
+
+#include <atomic>
+
+// A chunk of one folder's contents, as found by SnippetScanner.
+// A big folder is delivered in several chunks, the last one carries the sub-folders.
+struct ScannedFolder
+{
+    int generation = 0;
+    QString absolutePath;
+    QVector<SnippetData> snippets;
+    QStringList subFolders; // Names, relative to absolutePath
+};
+
+Q_DECLARE_METATYPE(ScannedFolder)
+
+// Walks the data folder in a worker thread and publishes what it finds in chunks,
+// so the GUI can show the first snippets while the rest is still being read.
+// With headersOnly, only titles and tags are read, which is enough for indexing.
+class SnippetScanner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SnippetScanner(const QString &rootPath, int generation,
+                            bool headersOnly = false, QObject *parent = nullptr);
+
+    // Runs in the worker thread
+    void run();
+
+    // Reads a single folder, not recursive. Used for on-demand fetching.
+    static ScannedFolder scanFolder(const QString &absolutePath, bool headersOnly);
+
+    // Thread-safe, run() returns soon after
+    void cancel();
+
+Q_SIGNALS:
+    void opened(int generation, const QString &rootPath); // The root's SnippetStorage, before any folder
+    void folderScanned(const ScannedFolder &);
+    void finished(int generation, const QString &rootPath);
+
+private:
+    const QString m_rootPath;
+    const int m_generation;
+    const bool m_headersOnly;
+    std::atomic<bool> m_cancelled;
+};
+
+#endif
@@ -0,0 +1,191 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "snippetstorage.h"
+#include "directorystorage.h"
+#include "packedstorage.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+
+static QMutex s_storagesMutex;
+
+static QHash<QString, SnippetStorage *> &storages()
+{
+    static QHash<QString, SnippetStorage *> s_storages;
+    return s_storages;
+}
+
+SnippetStorage::SnippetStorage(const QString &root)
+    : m_root(root)
+{
+}
+
+SnippetStorage::~SnippetStorage()
+{
+}
+
+/*static*/
+SnippetStorage *SnippetStorage::open(const QString &rootPath)
+{
+    {
+        QMutexLocker locker(&s_storagesMutex);
+        if (SnippetStorage *storage = storages().value(rootPath))
+            return storage;
+    }
+
+    // Without the lock, opening replays a journal or walks a pack and other roots shouldn't wait
+    SnippetStorage *opened = nullptr;
+    if (isPackedPath(rootPath))
+        opened = new PackedStorage(rootPath);
+    else
+        opened = new DirectoryStorage(rootPath);
+
+    QMutexLocker locker(&s_storagesMutex);
+    SnippetStorage *&storage = storages()[rootPath];
+    if (storage)
+        delete opened; // Opened twice at once, keep the first
+    else
+        storage = opened;
+
+    return storage;
+}
+
+/*static*/
+void SnippetStorage::closeAll()
+{
+    QHash<QString, SnippetStorage *> closing;
+    {
+        QMutexLocker locker(&s_storagesMutex);
+        closing.swap(storages());
+    }
+
+    foreach (SnippetStorage *storage, closing) {
+        storage->flush();
+        delete storage; // Stops the journal's compactor
+    }
+}
+
+/*static*/
+SnippetStorage *SnippetStorage::forPath(const QString &absolutePath)
+{
+    static DirectoryStorage s_fallback { QString() };
+
+    QMutexLocker locker(&s_storagesMutex);
+    SnippetStorage *best = nullptr;
+    foreach (SnippetStorage *storage, storages()) {
+        const QString &root = storage->m_root;
+        const bool contains = absolutePath.startsWith(root)
+            && (absolutePath.size() == root.size() || absolutePath.at(root.size()) == QLatin1Char('/'));
+        if (contains && (!best || root.size() > best->m_root.size()))
+            best = storage;
+    }
+
+    return best ? best : &s_fallback;
+}
+
+/*static*/
+bool SnippetStorage::isPackedPath(const QString &path)
+{
+    return path.endsWith(QLatin1String(".snippack"));
+}
+
+/*static*/
+bool SnippetStorage::convert(const QString &fromRoot, const QString &toRoot)
+{
+    if (QFileInfo::exists(toRoot)) {
+        qWarning() << Q_FUNC_INFO << "Refusing to overwrite" << toRoot;
+        return false;
+    }
+
+    SnippetStorage *source = open(fromRoot);
+    SnippetStorage *target = open(toRoot);
+    if (!target->makeFolder(toRoot))
+        return false;
+
+    int count = 0;
+    QStringList pendingFolders = { fromRoot };
+    while (!pendingFolders.isEmpty()) {
+        const QString folder = pendingFolders.takeLast();
+        const QString targetFolder = toRoot + folder.mid(fromRoot.size());
+        if (!target->makeFolder(targetFolder))
+            return false;
+
+        QStringList snippetNames;
+        QStringList subFolders;
+        if (!source->list(folder, snippetNames, subFolders))
+            return false;
+
+        foreach (const QString &name, snippetNames) {
+            SnippetData data;
+            if (!source->read(folder + QLatin1Char('/') + name, data))
+                return false;
+            if (!target->write(targetFolder + QLatin1Char('/') + name, data.title, data.tags, data.contents))
+                return false;
+            ++count;
+        }
+
+        foreach (const QString &subFolder, subFolders)
+            pendingFolders.append(folder + QLatin1Char('/') + subFolder);
+    }
+
+    qInfo().noquote() << "Copied" << count << "snippets from" << fromRoot << "to" << toRoot;
+    return true;
+}
+
+QString SnippetStorage::root() const
+{
+    return m_root;
+}
+
+bool SnippetStorage::contains(const QString &absolutePath, const QString &text)
+{
+    SnippetData data;
+    return read(absolutePath, data) && data.contents.contains(text, Qt::CaseInsensitive);
+}
+
+void SnippetStorage::flush()
+{
+}
+
+/*static*/
+QByteArray SnippetStorage::serialize(const QString &title, const QStringList &tags, const QString &contents)
+{
+    return title.toUtf8() + '\n' + tags.join(QLatin1Char(';')).toUtf8() + '\n' + contents.toUtf8();
+}
+
+/*static*/
+void SnippetStorage::parse(const QByteArray &bytes, SnippetData &data, bool headerOnly)
+{
+    const int titleEnd = bytes.indexOf('\n');
+    data.title = QString::fromUtf8(bytes.left(titleEnd)).trimmed(); // The whole thing if there's no newline
+
+    const int tagsEnd = titleEnd < 0 ? -1 : bytes.indexOf('\n', titleEnd + 1);
+    if (titleEnd >= 0)
+        data.tags = QString::fromUtf8(bytes.mid(titleEnd + 1, tagsEnd < 0 ? -1 : tagsEnd - titleEnd - 1)).trimmed().split(QLatin1Char(';'));
+
+    data.hasContents = !headerOnly;
+    if (!headerOnly && tagsEnd >= 0)
+        data.contents = QString::fromUtf8(bytes.mid(tagsEnd + 1));
+}
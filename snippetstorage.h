@@ -0,0 +1,89 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_SNIPPET_STORAGE_H
+#define SNIPPY_SNIPPET_STORAGE_H
+
+#include "snippet.h"
+
+#include <QString>
+#include <QStringList>
+
+// Where snippets are persisted, below a root path. Paths passed in are absolute, as built
+// by PathNode, so they start with root() even when the backend isn't a real folder.
+// A root ending in .snippack is a PackedStorage, anything else a DirectoryStorage.
+// Implementations are thread-safe, the scanner reads from its worker thread.
+
+class SnippetStorage
+{
+public:
+    virtual ~SnippetStorage();
+
+    // Opened once per root and kept until closeAll(), snippets and scanners hold plain pointers.
+    // Can be slow, it's called from the root's scanner thread.
+    static SnippetStorage *open(const QString &rootPath);
+
+    // At exit, once snippets saved what was pending. Flushes and deletes every open storage,
+    // so journals are folded into the files other programs read.
+    static void closeAll();
+
+    // The open storage whose root contains absolutePath, a plain DirectoryStorage if none does
+    static SnippetStorage *forPath(const QString &absolutePath);
+
+    static bool isPackedPath(const QString &path);
+
+    // Copies every folder and snippet, to convert between formats. toRoot must not exist yet.
+    static bool convert(const QString &fromRoot, const QString &toRoot);
+
+    QString root() const;
+
+    // Not recursive, both sorted by name
+    virtual bool list(const QString &folderPath, QStringList &snippetNames, QStringList &subFolders) = 0;
+
+    virtual bool read(const QString &absolutePath, SnippetData &data, bool headerOnly = false) = 0;
+    virtual bool contains(const QString &absolutePath, const QString &text); // Case insensitive, body only
+    virtual bool write(const QString &absolutePath, const QString &title,
+                       const QStringList &tags, const QString &contents) = 0;
+    virtual bool remove(const QString &absolutePath) = 0;
+    virtual bool exists(const QString &absolutePath) = 0;
+    virtual bool makeFolder(const QString &absolutePath) = 0;
+    virtual bool renameFolder(const QString &absolutePath, const QString &newAbsolutePath) = 0;
+
+    // Makes what was written visible to other programs, for backends that defer it
+    virtual void flush();
+
+    // Leaves the snippet as a plain text file that an external editor can change.
+    // False if the backend has no such file.
+    virtual bool makeEditable(const QString &absolutePath) = 0;
+
+    // The .snip layout, title line, tags line and then the body
+    static QByteArray serialize(const QString &title, const QStringList &tags, const QString &contents);
+    static void parse(const QByteArray &bytes, SnippetData &data, bool headerOnly);
+
+protected:
+    explicit SnippetStorage(const QString &root);
+
+private:
+    const QString m_root;
+};
+
+#endif
@@ -6,22 +6,62 @@ FORMS += mainwindow.ui
 
 SOURCES += main.cpp \
            mainwindow.cpp \
+           memorystats.cpp \
+           bodystore.cpp \
+           corpussnapshot.cpp \
+           pathnode.cpp \
            snippetmodel.cpp \
            snippetproxymodel.cpp \
+           filterquery.cpp \
+           flatresultsmodel.cpp \
+           snippetscanner.cpp \
+           snippetstorage.cpp \
+           directorystorage.cpp \
+           journal.cpp \
+           packedstorage.cpp \
            kernel.cpp \
            snippet.cpp \
+           snippetindex.cpp \
+           snippetitemdelegate.cpp \
            textedit.cpp \
-           syntaxhighlighter.cpp
+           tracer.cpp \
+           watchdog.cpp \
+           syntaxhighlighter.cpp \
+           tagdictionary.cpp \
+           tagfacetmodel.cpp \
+           tagslineedit.cpp \
+           tagtrie.cpp \
+           singleinstance.cpp
 
 HEADERS += snippetmodel.h \
            snippetproxymodel.h \
+           filterquery.h \
+           flatresultsmodel.h \
+           snippetscanner.h \
+           snippetstorage.h \
+           directorystorage.h \
+           journal.h \
+           packedstorage.h \
            mainwindow.h \
+           memorystats.h \
+           pathnode.h \
            kernel.h \
+           bodystore.h \
+           corpussnapshot.h \
            snippet.h \
+           snippetindex.h \
+           snippetitemdelegate.h \
            textedit.h \
-           syntaxhighlighter.h
+           tracer.h \
+           watchdog.h \
+           syntaxhighlighter.h \
+           tagdictionary.h \
+           tagfacetmodel.h \
+           tagslineedit.h \
+           tagtrie.h \
+           singleinstance.h
 
 RESOURCES += resources.qrc
 
-QT += widgets qml
+QT += widgets network
 CONFIG += c++11
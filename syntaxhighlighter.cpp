@@ -21,20 +21,65 @@
 */
 
 #include "syntaxhighlighter.h"
+#include "tracer.h"
 
 #include <QDebug>
-#include <QRegularExpression>
+#include <QTextBlock>
+#include <QTextDocument>
+
+#include <algorithm>
 
 SyntaxHighlighter::SyntaxHighlighter(QTextDocument *parent)
     : QSyntaxHighlighter(parent)
 {
+    connect(parent, &QTextDocument::contentsChange, this, &SyntaxHighlighter::onContentsChange);
+}
+
+void SyntaxHighlighter::setSpans(const QVector<MatchSpan> &spans)
+{
+    if (spans == m_spans)
+        return;
+
+    m_spans = spans;
+    SNIPPY_TRACE("SyntaxHighlighter::rehighlight");
+    rehighlight();
+}
+
+void SyntaxHighlighter::reset()
+{
+    m_spans.clear();
 }
 
-void SyntaxHighlighter::setTokens(const QStringList &tokens)
+void SyntaxHighlighter::onContentsChange(int position, int charsRemoved, int charsAdded)
 {
-    if (m_tokens != tokens) {
-        m_tokens = tokens;
-        rehighlight();
+    if (m_spans.isEmpty())
+        return;
+
+    // Spans touching the edit are dropped, the ones after it move along. Typed text isn't
+    // searched, the next filter change finds it.
+    QVector<MatchSpan> spans;
+    spans.reserve(m_spans.size());
+    bool changed = false;
+    for (MatchSpan span : m_spans) {
+        if (span.start + span.length < position) {
+            spans.append(span);
+        } else if (span.start > position + charsRemoved) {
+            span.start += charsAdded - charsRemoved;
+            spans.append(span);
+        } else {
+            changed = true;
+        }
+    }
+    m_spans = spans;
+
+    // QSyntaxHighlighter reformatted the edited blocks before this ran, with the old spans
+    if (changed || charsAdded != charsRemoved) {
+        const QTextBlock last = document()->findBlock(position + charsAdded);
+        for (QTextBlock block = document()->findBlock(position); block.isValid(); block = block.next()) {
+            rehighlightBlock(block);
+            if (block == last)
+                break;
+        }
     }
 }
 
@@ -45,15 +90,16 @@ void SyntaxHighlighter::highlightBlock(const QString &text)
     myClassFormat.setForeground(Qt::darkBlue);
     myClassFormat.setBackground(Qt::yellow);
 
-    for (const auto &token : m_tokens) {
-        if (token.isEmpty())
-            continue;
+    const int blockStart = currentBlock().position();
+    const int blockEnd = blockStart + text.size();
 
-        QRegularExpression expression(token, QRegularExpression::CaseInsensitiveOption);
-        QRegularExpressionMatchIterator iterator = expression.globalMatch(text);
-        while (iterator.hasNext()) {
-            QRegularExpressionMatch match = iterator.next();
-            setFormat(match.capturedStart(), match.capturedLength(), myClassFormat);
-        }
+    // First span ending inside or after this block
+    auto it = std::lower_bound(m_spans.cbegin(), m_spans.cend(), blockStart, [](const MatchSpan &span, int position) {
+        return span.start + span.length <= position;
+    });
+    for (; it != m_spans.cend() && it->start < blockEnd; ++it) {
+        const int start = qMax(it->start, blockStart);
+        const int end = qMin(it->start + it->length, blockEnd);
+        setFormat(start - blockStart, end - start, myClassFormat);
     }
 }
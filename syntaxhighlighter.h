@@ -23,22 +23,33 @@
 #ifndef SYNTAXHIGHLIGHTER_H
 #define SYNTAXHIGHLIGHTER_H
 
+#include "filterquery.h"
+
 #include <QSyntaxHighlighter>
-#include <QStringList>
+#include <QVector>
 
 class QTextDocument;
 
+// Highlights where the filter matched, from spans the filter computed, see
+// SnippetProxyModel::bodyMatchSpans(). Edits move the spans along instead of searching again.
+
 class SyntaxHighlighter : public QSyntaxHighlighter
 {
 public:
     explicit SyntaxHighlighter(QTextDocument *parent);
-    void setTokens(const QStringList &);
+
+    // In document positions, sorted and not overlapping. Set after the document's text.
+    void setSpans(const QVector<MatchSpan> &);
+    // Forgets them without reformatting, before the document's text gets replaced, so that the
+    // new text isn't formatted with spans of the old one
+    void reset();
 
 protected:
     void highlightBlock(const QString &text) override;
 
 private:
-    QStringList m_tokens;
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    QVector<MatchSpan> m_spans;
 };
 
 #endif
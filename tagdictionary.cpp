@@ -0,0 +1,273 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "tagdictionary.h"
+
+#include <algorithm>
+
+enum {
+    BitsPerWord = 64
+};
+
+void TagSet::insert(int id)
+{
+    if (id < BitsPerWord) {
+        m_bits |= quint64(1) << id;
+        return;
+    }
+
+    const int word = id / BitsPerWord - 1;
+    if (word >= m_overflow.size())
+        m_overflow.resize(word + 1);
+    m_overflow[word] |= quint64(1) << (id % BitsPerWord);
+}
+
+void TagSet::remove(int id)
+{
+    if (id < BitsPerWord) {
+        m_bits &= ~(quint64(1) << id);
+        return;
+    }
+
+    const int word = id / BitsPerWord - 1;
+    if (word < m_overflow.size())
+        m_overflow[word] &= ~(quint64(1) << (id % BitsPerWord));
+}
+
+bool TagSet::contains(int id) const
+{
+    if (id < BitsPerWord)
+        return m_bits & (quint64(1) << id);
+
+    const int word = id / BitsPerWord - 1;
+    return word < m_overflow.size() && (m_overflow.at(word) & (quint64(1) << (id % BitsPerWord)));
+}
+
+bool TagSet::contains(const TagSet &other) const
+{
+    if ((m_bits & other.m_bits) != other.m_bits)
+        return false;
+
+    for (int i = 0; i < other.m_overflow.size(); ++i) {
+        const quint64 word = i < m_overflow.size() ? m_overflow.at(i) : 0;
+        if ((word & other.m_overflow.at(i)) != other.m_overflow.at(i))
+            return false;
+    }
+
+    return true;
+}
+
+qint64 TagSet::memoryUsage() const
+{
+    return sizeof(TagSet) + m_overflow.capacity() * qint64(sizeof(quint64));
+}
+
+bool TagSet::intersects(const TagSet &other) const
+{
+    if (m_bits & other.m_bits)
+        return true;
+
+    const int words = qMin(m_overflow.size(), other.m_overflow.size());
+    for (int i = 0; i < words; ++i) {
+        if (m_overflow.at(i) & other.m_overflow.at(i))
+            return true;
+    }
+
+    return false;
+}
+
+bool TagSet::isEmpty() const
+{
+    if (m_bits)
+        return false;
+
+    for (quint64 word : m_overflow) {
+        if (word)
+            return false;
+    }
+
+    return true;
+}
+
+QVector<int> TagSet::ids() const
+{
+    QVector<int> result;
+    for (int i = 0; i < BitsPerWord; ++i) {
+        if (m_bits & (quint64(1) << i))
+            result.append(i);
+    }
+
+    for (int w = 0; w < m_overflow.size(); ++w) {
+        for (int i = 0; i < BitsPerWord; ++i) {
+            if (m_overflow.at(w) & (quint64(1) << i))
+                result.append((w + 1) * BitsPerWord + i);
+        }
+    }
+
+    return result;
+}
+
+bool TagSet::operator==(const TagSet &other) const
+{
+    if (m_bits != other.m_bits)
+        return false;
+
+    // Trailing zero words don't count
+    const int words = qMax(m_overflow.size(), other.m_overflow.size());
+    for (int i = 0; i < words; ++i) {
+        const quint64 a = i < m_overflow.size() ? m_overflow.at(i) : 0;
+        const quint64 b = i < other.m_overflow.size() ? other.m_overflow.at(i) : 0;
+        if (a != b)
+            return false;
+    }
+
+    return true;
+}
+
+TagDictionary &TagDictionary::instance()
+{
+    static TagDictionary dictionary;
+    return dictionary;
+}
+
+int TagDictionary::intern(const QString &tag)
+{
+    auto it = m_ids.constFind(tag);
+    if (it != m_ids.constEnd())
+        return it.value();
+
+    const int id = m_tags.size();
+    m_tags.append(tag);
+    m_usage.append(0);
+    m_ids.insert(tag, id);
+    m_trie.insert(tag, id);
+    emit tagAdded(id);
+    return id;
+}
+
+QString TagDictionary::tag(int id) const
+{
+    return m_tags.value(id);
+}
+
+int TagDictionary::count() const
+{
+    return m_tags.size();
+}
+
+int TagDictionary::usageCount(int id) const
+{
+    return m_usage.value(id);
+}
+
+void TagDictionary::addUsage(const TagSet &set)
+{
+    if (set.isEmpty())
+        return;
+
+    for (int id : set.ids())
+        m_usage[id]++;
+    emit usageChanged();
+}
+
+void TagDictionary::removeUsage(const TagSet &set)
+{
+    if (set.isEmpty())
+        return;
+
+    for (int id : set.ids())
+        m_usage[id]--;
+    emit usageChanged();
+}
+
+QVector<int> TagDictionary::tagIds(const QStringList &tags)
+{
+    QVector<int> ids;
+    ids.reserve(tags.size());
+    for (const QString &tag : tags) {
+        const QString trimmed = tag.trimmed();
+        if (trimmed.isEmpty())
+            continue;
+
+        const int id = intern(trimmed);
+        if (!ids.contains(id))
+            ids.append(id);
+    }
+
+    return ids;
+}
+
+QStringList TagDictionary::tags(const QVector<int> &ids) const
+{
+    QStringList result;
+    result.reserve(ids.size());
+    for (int id : ids)
+        result.append(m_tags.at(id));
+
+    return result;
+}
+
+TagSet TagDictionary::matching(const QString &text) const
+{
+    TagSet set;
+    for (int id = 0, count = m_tags.size(); id < count; ++id) {
+        if (m_tags.at(id).contains(text, Qt::CaseInsensitive))
+            set.insert(id);
+    }
+
+    return set;
+}
+
+QStringList TagDictionary::completions(const QString &prefix, int limit) const
+{
+    QVector<int> ids = m_trie.withPrefix(prefix);
+    ids.erase(std::remove_if(ids.begin(), ids.end(), [this](int id) {
+                  return m_usage.at(id) == 0; // Only left behind by edits
+              }),
+              ids.end());
+
+    limit = qMin(limit, ids.size());
+    std::partial_sort(ids.begin(), ids.begin() + limit, ids.end(), [this](int a, int b) {
+        if (m_usage.at(a) != m_usage.at(b))
+            return m_usage.at(a) > m_usage.at(b);
+        return m_tags.at(a) < m_tags.at(b);
+    });
+
+    QStringList result;
+    result.reserve(limit);
+    for (int i = 0; i < limit; ++i)
+        result << m_tags.at(ids.at(i));
+
+    return result;
+}
+
+MemoryUsage TagDictionary::memoryUsage() const
+{
+    MemoryUsage usage;
+    usage.objects = m_tags.size();
+    foreach (const QString &tag, m_tags)
+        usage.bytes += MemoryStats::stringBytes(tag); // Shared by the list and the hash
+    usage.bytes += m_tags.size() * qint64(sizeof(QString) + sizeof(QString) + sizeof(int) + 2 * sizeof(void *));
+    usage.bytes += m_usage.capacity() * qint64(sizeof(int));
+    usage.bytes += m_trie.memoryUsage();
+    return usage;
+}
@@ -0,0 +1,102 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_TAG_DICTIONARY_H
+#define SNIPPY_TAG_DICTIONARY_H
+
+#include "memorystats.h"
+#include "tagtrie.h"
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// A set of tag ids, as handed out by TagDictionary.
+// The first 64 ids live inline, which covers most corpora without any allocation.
+
+class TagSet
+{
+public:
+    void insert(int id);
+    void remove(int id);
+    bool contains(int id) const;
+    bool contains(const TagSet &) const; // All of them
+    bool intersects(const TagSet &) const;
+    bool isEmpty() const;
+    QVector<int> ids() const;
+    qint64 memoryUsage() const;
+    bool operator==(const TagSet &) const;
+    bool operator!=(const TagSet &other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    quint64 m_bits = 0; // ids 0 to 63
+    QVector<quint64> m_overflow; // ids from 64 on
+};
+
+// Maps each distinct tag to a small integer id, so snippets don't each carry their own copy
+// of the same strings and tag predicates become bit operations. GUI thread only.
+// Also counts how many snippets use each tag, kept up to date by Snippet.
+
+class TagDictionary : public QObject
+{
+    Q_OBJECT
+public:
+    static TagDictionary &instance();
+
+    int intern(const QString &tag);
+    QString tag(int id) const;
+    int count() const;
+
+    int usageCount(int id) const;
+    void addUsage(const TagSet &);
+    void removeUsage(const TagSet &);
+
+    // In the order given, without duplicates. Snippets keep it so saving doesn't reorder their tags.
+    QVector<int> tagIds(const QStringList &tags);
+    QStringList tags(const QVector<int> &ids) const;
+
+    // Ids of every tag containing text, case insensitive
+    TagSet matching(const QString &text) const;
+
+    // Tags in use starting with prefix, most used first
+    QStringList completions(const QString &prefix, int limit) const;
+
+    MemoryUsage memoryUsage() const;
+
+Q_SIGNALS:
+    void tagAdded(int id);
+    void usageChanged();
+
+private:
+    TagDictionary() = default;
+    QHash<QString, int> m_ids;
+    QStringList m_tags;
+    QVector<int> m_usage; // Indexed by id
+    TagTrie m_trie;
+};
+
+#endif
@@ -0,0 +1,118 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "tagfacetmodel.h"
+#include "snippetproxymodel.h"
+#include "tagdictionary.h"
+
+TagFacetModel::TagFacetModel(SnippetProxyModel *filterModel, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_filterModel(filterModel)
+    , m_rowCount(TagDictionary::instance().count())
+{
+    // Counts change once per snippet while loading, repaint once per event loop run instead
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(0);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &TagFacetModel::refresh);
+
+    const TagDictionary &dictionary = TagDictionary::instance();
+    connect(&dictionary, &TagDictionary::tagAdded, this, &TagFacetModel::onTagAdded);
+    connect(&dictionary, &TagDictionary::usageChanged, this, &TagFacetModel::scheduleRefresh);
+    connect(m_filterModel, &SnippetProxyModel::matchingTagCountsChanged, this, &TagFacetModel::scheduleRefresh);
+    connect(m_filterModel, &SnippetProxyModel::requiredTagsChanged, this, &TagFacetModel::scheduleRefresh);
+}
+
+int TagFacetModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rowCount;
+}
+
+QVariant TagFacetModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rowCount)
+        return QVariant();
+
+    const TagDictionary &dictionary = TagDictionary::instance();
+    const int id = index.row();
+
+    switch (role) {
+    case Qt::DisplayRole: {
+        const int total = dictionary.usageCount(id);
+        if (m_filterModel->isFiltering())
+            return QStringLiteral("%1  %2/%3").arg(dictionary.tag(id)).arg(m_filterModel->matchingTagCount(id)).arg(total);
+        return QStringLiteral("%1  %2").arg(dictionary.tag(id)).arg(total);
+    }
+    case Qt::CheckStateRole:
+        return m_filterModel->requiredTags().contains(id) ? Qt::Checked : Qt::Unchecked;
+    case TagRole:
+        return dictionary.tag(id);
+    case TagIdRole:
+        return id;
+    }
+
+    return QVariant();
+}
+
+Qt::ItemFlags TagFacetModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return Qt::NoItemFlags;
+
+    // Not user-checkable, the view toggles on click, so the whole row is a target
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+void TagFacetModel::toggle(const QModelIndex &index)
+{
+    if (!index.isValid() || index.row() >= m_rowCount)
+        return;
+
+    TagSet tags = m_filterModel->requiredTags();
+    if (tags.contains(index.row()))
+        tags.remove(index.row());
+    else
+        tags.insert(index.row());
+
+    m_filterModel->setRequiredTags(tags);
+}
+
+void TagFacetModel::onTagAdded(int id)
+{
+    if (id < m_rowCount)
+        return;
+
+    beginInsertRows(QModelIndex(), m_rowCount, id);
+    m_rowCount = id + 1;
+    endInsertRows();
+}
+
+void TagFacetModel::scheduleRefresh()
+{
+    if (!m_refreshTimer.isActive())
+        m_refreshTimer.start();
+}
+
+void TagFacetModel::refresh()
+{
+    if (m_rowCount > 0)
+        emit dataChanged(index(0), index(m_rowCount - 1), { Qt::DisplayRole, Qt::CheckStateRole });
+}
@@ -0,0 +1,64 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_TAG_FACET_MODEL_H
+#define SNIPPY_TAG_FACET_MODEL_H
+
+#include <QAbstractListModel>
+#include <QTimer>
+
+class SnippetProxyModel;
+
+// One row per known tag, showing how many snippets have it within the current filter
+// and overall. Checked tags are required by the filter.
+// Row numbers are tag ids, the counts come from TagDictionary and SnippetProxyModel,
+// which keep them up to date, nothing is counted here.
+
+class TagFacetModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Role {
+        TagRole = Qt::UserRole + 1,
+        TagIdRole
+    };
+
+    explicit TagFacetModel(SnippetProxyModel *filterModel, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    // Adds or removes the tag from the filter's required tags
+    void toggle(const QModelIndex &index);
+
+private:
+    void onTagAdded(int id);
+    void scheduleRefresh();
+    void refresh();
+
+    SnippetProxyModel *const m_filterModel;
+    int m_rowCount = 0;
+    QTimer m_refreshTimer;
+};
+
+#endif
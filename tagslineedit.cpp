@@ -0,0 +1,147 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "tagslineedit.h"
+#include "tagdictionary.h"
+
+#include <QAbstractItemView>
+#include <QCompleter>
+#include <QKeyEvent>
+#include <QStringListModel>
+
+#include <algorithm>
+
+TagsLineEdit::TagsLineEdit(QWidget *parent)
+    : QLineEdit(parent)
+    , m_completer(new QCompleter(this))
+    , m_completionModel(new QStringListModel(this))
+{
+    // Already ranked by the dictionary, the completer only shows them
+    m_completer->setModel(m_completionModel);
+    m_completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    m_completer->setWidget(this);
+    connect(m_completer, QOverload<const QString &>::of(&QCompleter::activated), this, &TagsLineEdit::insertCompletion);
+
+    connect(this, &QLineEdit::textEdited, this, &TagsLineEdit::onTextEdited);
+    connect(this, &QLineEdit::editingFinished, this, &TagsLineEdit::commit);
+}
+
+void TagsLineEdit::setCommittedText(const QString &text)
+{
+    m_committedText = text;
+    setText(text);
+    m_completer->popup()->hide();
+}
+
+void TagsLineEdit::commit()
+{
+    if (text() != m_committedText) {
+        m_committedText = text();
+        emit tagsEdited(m_committedText);
+    }
+}
+
+void TagsLineEdit::keyPressEvent(QKeyEvent *ev)
+{
+    if (m_completer->popup()->isVisible()) {
+        switch (ev->key()) {
+        case Qt::Key_Enter:
+        case Qt::Key_Return:
+        case Qt::Key_Escape:
+        case Qt::Key_Tab:
+        case Qt::Key_Backtab:
+            ev->ignore(); // The completer handles these
+            return;
+        default:
+            break;
+        }
+    }
+
+    QLineEdit::keyPressEvent(ev);
+}
+
+void TagsLineEdit::onTextEdited(const QString &text)
+{
+    const int cursor = cursorPosition();
+    if (cursor > 0 && text.at(cursor - 1) == QLatin1Char(';')) {
+        m_completer->popup()->hide();
+        commit();
+        return;
+    }
+
+    updateCompletions();
+}
+
+void TagsLineEdit::updateCompletions()
+{
+    const QString current = text();
+    const QString prefix = current.mid(currentTokenStart(), cursorPosition() - currentTokenStart()).trimmed();
+    if (prefix.isEmpty()) {
+        m_completer->popup()->hide();
+        return;
+    }
+
+    // Don't offer what's already there
+    QStringList existing = current.split(QLatin1Char(';'));
+    for (QString &tag : existing)
+        tag = tag.trimmed();
+
+    QStringList completions = TagDictionary::instance().completions(prefix, MaxCompletions + existing.size());
+    completions.erase(std::remove_if(completions.begin(), completions.end(), [&existing](const QString &tag) {
+                          return existing.contains(tag);
+                      }),
+                      completions.end());
+    completions = completions.mid(0, MaxCompletions);
+
+    m_completionModel->setStringList(completions);
+    if (completions.isEmpty())
+        m_completer->popup()->hide();
+    else
+        m_completer->complete();
+}
+
+void TagsLineEdit::insertCompletion(const QString &tag)
+{
+    const QString current = text();
+    const int start = currentTokenStart();
+    const int end = currentTokenEnd();
+    const QString separator = QStringLiteral(";");
+    const QString tail = current.mid(end);
+
+    QString newText = current.left(start) + tag;
+    newText += tail.startsWith(separator) ? tail : separator + tail;
+    setText(newText);
+    setCursorPosition(start + tag.size() + 1);
+    commit();
+}
+
+int TagsLineEdit::currentTokenStart() const
+{
+    const int cursor = cursorPosition();
+    return cursor == 0 ? 0 : text().lastIndexOf(QLatin1Char(';'), cursor - 1) + 1;
+}
+
+int TagsLineEdit::currentTokenEnd() const
+{
+    const int end = text().indexOf(QLatin1Char(';'), cursorPosition());
+    return end == -1 ? text().size() : end;
+}
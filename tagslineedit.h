@@ -0,0 +1,69 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_TAGS_LINE_EDIT_H
+#define SNIPPY_TAGS_LINE_EDIT_H
+
+#include <QLineEdit>
+
+class QCompleter;
+class QStringListModel;
+
+// Edits a ';' separated tag list, completing the tag under the cursor with known tags.
+// Edits are only reported once a tag is finished: a ';' was typed, a completion was
+// picked, or editing ended.
+
+class TagsLineEdit : public QLineEdit
+{
+    Q_OBJECT
+public:
+    explicit TagsLineEdit(QWidget *parent = nullptr);
+
+    // Sets the text without reporting it as an edit
+    void setCommittedText(const QString &);
+
+    // Reports pending edits, if any
+    void commit();
+
+Q_SIGNALS:
+    void tagsEdited(const QString &text);
+
+protected:
+    void keyPressEvent(QKeyEvent *ev) override;
+
+private:
+    enum {
+        MaxCompletions = 10
+    };
+
+    void onTextEdited(const QString &text);
+    void insertCompletion(const QString &tag);
+    void updateCompletions();
+    int currentTokenStart() const;
+    int currentTokenEnd() const;
+
+    QCompleter *const m_completer;
+    QStringListModel *const m_completionModel;
+    QString m_committedText;
+};
+
+#endif
@@ -0,0 +1,89 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "tagtrie.h"
+
+#include <algorithm>
+
+static bool lessThanChar(const QPair<QChar, int> &child, QChar c)
+{
+    return child.first < c;
+}
+
+TagTrie::TagTrie()
+    : m_nodes(1)
+{
+}
+
+int TagTrie::child(int node, QChar c) const
+{
+    const QVector<QPair<QChar, int>> &children = m_nodes.at(node).children;
+    auto it = std::lower_bound(children.cbegin(), children.cend(), c, lessThanChar);
+    return (it != children.cend() && it->first == c) ? it->second : -1;
+}
+
+void TagTrie::insert(const QString &key, int id)
+{
+    int node = 0;
+    for (QChar c : key.toLower()) {
+        int next = child(node, c);
+        if (next == -1) {
+            next = m_nodes.size();
+            m_nodes.append(Node()); // Might reallocate, so look up the parent's children afterwards
+            QVector<QPair<QChar, int>> &children = m_nodes[node].children;
+            children.insert(std::lower_bound(children.begin(), children.end(), c, lessThanChar), qMakePair(c, next));
+        }
+        node = next;
+    }
+
+    m_nodes[node].ids.append(id);
+}
+
+QVector<int> TagTrie::withPrefix(const QString &prefix) const
+{
+    QVector<int> result;
+    int node = 0;
+    for (QChar c : prefix.toLower()) {
+        node = child(node, c);
+        if (node == -1)
+            return result;
+    }
+
+    QVector<int> pending = { node };
+    while (!pending.isEmpty()) {
+        const Node &current = m_nodes.at(pending.takeLast());
+        result += current.ids;
+        for (const auto &c : current.children)
+            pending.append(c.second);
+    }
+
+    return result;
+}
+
+qint64 TagTrie::memoryUsage() const
+{
+    qint64 bytes = m_nodes.capacity() * qint64(sizeof(Node));
+    foreach (const Node &node, m_nodes)
+        bytes += node.children.capacity() * qint64(sizeof(QPair<QChar, int>)) + node.ids.capacity() * qint64(sizeof(int));
+
+    return bytes;
+}
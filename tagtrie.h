@@ -0,0 +1,56 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_TAG_TRIE_H
+#define SNIPPY_TAG_TRIE_H
+
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+// Prefix tree from tag to tag id, case insensitive.
+// A lookup only walks the prefix's characters and then the subtree below it,
+// so it doesn't depend on how many unrelated tags exist.
+
+class TagTrie
+{
+public:
+    TagTrie();
+    void insert(const QString &key, int id);
+
+    // Ids of every key starting with prefix
+    QVector<int> withPrefix(const QString &prefix) const;
+
+    qint64 memoryUsage() const; // In bytes
+
+private:
+    struct Node
+    {
+        QVector<QPair<QChar, int>> children; // Sorted by character, the int indexes m_nodes
+        QVector<int> ids; // Keys ending here
+    };
+
+    int child(int node, QChar c) const;
+    QVector<Node> m_nodes; // m_nodes[0] is the root
+};
+
+#endif
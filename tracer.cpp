@@ -0,0 +1,204 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "tracer.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+
+std::atomic<bool> Tracer::s_enabled(false);
+std::atomic<bool> Tracer::s_recording(false);
+std::atomic<bool> Tracer::s_trackOperations(false);
+
+namespace {
+
+struct Event
+{
+    const char *name;
+    qint64 start;
+    qint64 duration;
+    int threadId;
+    QString args;
+};
+
+struct TraceData
+{
+    TraceData()
+    {
+        clock.start();
+    }
+
+    QMutex mutex;
+    QString fileName;
+    QElapsedTimer clock;
+    QVector<Event> events;
+    QVector<Tracer::Operation> guiOperations;
+    QHash<Qt::HANDLE, int> threadIds; // Small, stable numbers read better in the viewer
+    QHash<int, QString> threadNames;
+
+    int currentThreadId() // With the mutex locked
+    {
+        const Qt::HANDLE handle = QThread::currentThreadId();
+        auto it = threadIds.constFind(handle);
+        if (it != threadIds.constEnd())
+            return it.value();
+
+        const int id = threadIds.size() + 1;
+        threadIds.insert(handle, id);
+        if (!threadNames.contains(id))
+            threadNames.insert(id, id == 1 ? QStringLiteral("gui") : QStringLiteral("worker %1").arg(id - 1));
+        return id;
+    }
+};
+
+}
+
+static TraceData &traceData()
+{
+    static TraceData data;
+    return data;
+}
+
+void Tracer::start(const QString &fileName)
+{
+    TraceData &data = traceData();
+    QMutexLocker locker(&data.mutex);
+    data.fileName = fileName;
+    data.events.clear();
+    data.currentThreadId(); // The GUI thread is the one starting, make it thread 1
+    s_recording = true;
+    updateEnabled();
+}
+
+void Tracer::stop()
+{
+    if (!s_recording.load(std::memory_order_relaxed))
+        return;
+
+    TraceData &data = traceData();
+    QMutexLocker locker(&data.mutex);
+    s_recording = false;
+    updateEnabled();
+
+    QJsonArray events;
+    for (auto it = data.threadNames.cbegin(), end = data.threadNames.cend(); it != end; ++it) {
+        events.append(QJsonObject { { "name", "thread_name" }, { "ph", "M" }, { "pid", 1 }, { "tid", it.key() },
+                                    { "args", QJsonObject { { "name", it.value() } } } });
+    }
+
+    for (const Event &event : data.events) {
+        QJsonObject object { { "name", QString::fromLatin1(event.name) },
+                             { "ph", "X" },
+                             { "pid", 1 },
+                             { "tid", event.threadId },
+                             { "ts", event.start },
+                             { "dur", event.duration } };
+        if (!event.args.isEmpty())
+            object.insert(QStringLiteral("args"), QJsonObject { { "detail", event.args } });
+        events.append(object);
+    }
+
+    QFile file(data.fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << Q_FUNC_INFO << "Failed to write trace" << data.fileName << file.errorString();
+        return;
+    }
+
+    file.write(QJsonDocument(QJsonObject { { "traceEvents", events }, { "displayTimeUnit", "ms" } }).toJson(QJsonDocument::Compact));
+    qDebug() << Q_FUNC_INFO << "Wrote" << data.events.size() << "events to" << data.fileName;
+    data.events.clear();
+}
+
+qint64 Tracer::now()
+{
+    return traceData().clock.nsecsElapsed() / 1000;
+}
+
+void Tracer::record(const char *name, qint64 start, qint64 duration, const QString &args)
+{
+    TraceData &data = traceData();
+    QMutexLocker locker(&data.mutex);
+    if (!s_recording.load(std::memory_order_relaxed))
+        return;
+
+    data.events.append({ name, start, duration, data.currentThreadId(), args });
+}
+
+void Tracer::setThreadName(const QString &name)
+{
+    if (!s_recording.load(std::memory_order_relaxed))
+        return;
+
+    TraceData &data = traceData();
+    QMutexLocker locker(&data.mutex);
+    data.threadNames.insert(data.currentThreadId(), name);
+}
+
+void Tracer::setTrackOperations(bool track)
+{
+    TraceData &data = traceData();
+    QMutexLocker locker(&data.mutex);
+    s_trackOperations = track;
+    data.guiOperations.clear();
+    updateEnabled();
+}
+
+QVector<Tracer::Operation> Tracer::currentOperations()
+{
+    TraceData &data = traceData();
+    QMutexLocker locker(&data.mutex);
+    return data.guiOperations;
+}
+
+bool Tracer::enter(const Operation &operation)
+{
+    if (!s_trackOperations.load(std::memory_order_relaxed) || QThread::currentThread() != qApp->thread())
+        return false;
+
+    TraceData &data = traceData();
+    QMutexLocker locker(&data.mutex);
+    data.guiOperations.append(operation);
+    return true;
+}
+
+void Tracer::leave()
+{
+    TraceData &data = traceData();
+    QMutexLocker locker(&data.mutex);
+    if (!data.guiOperations.isEmpty()) // Tracking might have been turned off and on meanwhile
+        data.guiOperations.removeLast();
+}
+
+void Tracer::updateEnabled()
+{
+    s_enabled.store(s_recording.load(std::memory_order_relaxed) || s_trackOperations.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+}
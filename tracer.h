@@ -0,0 +1,116 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_TRACER_H
+#define SNIPPY_TRACER_H
+
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+// Records spans of the hot paths and writes them as a Chrome trace-event JSON file,
+// which chrome://tracing and ui.perfetto.dev can open.
+// Enabled with SNIPPY_TRACE=<file> or --trace <file>. When disabled a span costs one
+// relaxed load of a global bool, its arguments aren't even built.
+// Thread-safe, every span carries the id of the thread it ran in.
+// The same spans tell the Watchdog which operation the GUI thread is in.
+
+class Tracer
+{
+public:
+    struct Operation
+    {
+        const char *name;
+        QString args;
+        qint64 start;
+    };
+
+    // True if spans are being recorded or operations tracked
+    static bool isEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    static void start(const QString &fileName);
+    static void stop(); // Writes the file
+
+    // Keeps the stack of spans the GUI thread is in, for currentOperations()
+    static void setTrackOperations(bool);
+    static QVector<Operation> currentOperations(); // Outermost first, can be called from any thread
+
+    static qint64 now(); // Microseconds since start()
+    static void record(const char *name, qint64 start, qint64 duration, const QString &args = QString());
+
+    // Names the calling thread in the trace
+    static void setThreadName(const QString &);
+
+private:
+    friend class TraceScope;
+    static bool enter(const Operation &); // Returns true if it was pushed
+    static void leave();
+    static void updateEnabled();
+
+    // Written under the trace mutex, read without it from any thread
+    static std::atomic<bool> s_enabled;
+    static std::atomic<bool> s_recording;
+    static std::atomic<bool> s_trackOperations;
+};
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name, const QString &args = QString())
+        : m_name(Tracer::isEnabled() ? name : nullptr)
+        , m_start(m_name ? Tracer::now() : 0)
+        , m_args(args)
+        , m_entered(m_name && Tracer::enter({ name, args, m_start }))
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (m_entered)
+            Tracer::leave();
+        if (m_name)
+            Tracer::record(m_name, m_start, Tracer::now() - m_start, m_args);
+    }
+
+private:
+    Q_DISABLE_COPY(TraceScope)
+    const char *const m_name;
+    const qint64 m_start;
+    const QString m_args;
+    const bool m_entered;
+};
+
+#define SNIPPY_TRACE_CONCAT2(a, b) a##b
+#define SNIPPY_TRACE_CONCAT(a, b) SNIPPY_TRACE_CONCAT2(a, b)
+#define SNIPPY_TRACE_VAR SNIPPY_TRACE_CONCAT(snippyTraceScope, __LINE__)
+
+// Traces the rest of the enclosing scope
+#define SNIPPY_TRACE(name) TraceScope SNIPPY_TRACE_VAR(name)
+
+// Same, args is only evaluated when tracing is enabled
+#define SNIPPY_TRACE_ARGS(name, args) TraceScope SNIPPY_TRACE_VAR(name, Tracer::isEnabled() ? QString(args) : QString())
+
+#endif
@@ -0,0 +1,190 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#include "watchdog.h"
+#include "tracer.h"
+
+#include <QDebug>
+#include <QStringList>
+#include <QThread>
+
+#include <algorithm>
+
+static qint64 nowMs()
+{
+    return Tracer::now() / 1000;
+}
+
+Watchdog::Watchdog(QObject *parent)
+    : QObject(parent)
+    , m_stopRequested(false)
+    , m_pendingPing(-1)
+    , m_stallReported(false)
+    , m_buckets(NumBuckets, 0)
+{
+}
+
+Watchdog::~Watchdog()
+{
+    stop();
+}
+
+void Watchdog::start(int thresholdMs)
+{
+    if (m_thread)
+        return;
+
+    m_thresholdMs = thresholdMs;
+    m_stopRequested = false;
+    m_pendingPing = -1;
+    Tracer::setTrackOperations(true);
+
+    m_thread = QThread::create([this] {
+        run();
+    });
+    m_thread->start();
+    qDebug() << Q_FUNC_INFO << "Watching for GUI stalls longer than" << thresholdMs << "ms";
+}
+
+void Watchdog::stop()
+{
+    if (!m_thread)
+        return;
+
+    m_stopRequested = true;
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    Tracer::setTrackOperations(false);
+}
+
+bool Watchdog::isRunning() const
+{
+    return m_thread;
+}
+
+void Watchdog::run()
+{
+    Tracer::setThreadName(QStringLiteral("watchdog"));
+
+    while (!m_stopRequested) {
+        QThread::msleep(PingIntervalMs);
+
+        const qint64 sentAt = m_pendingPing;
+        if (sentAt < 0) {
+            const qint64 now = nowMs();
+            m_pendingPing = now;
+            m_stallReported = false;
+            QMetaObject::invokeMethod(this, [this, now] {
+                acknowledge(now);
+            }, Qt::QueuedConnection);
+        } else if (!m_stallReported && nowMs() - sentAt > m_thresholdMs) {
+            // Still blocked, say where while it's happening
+            m_stallReported = true;
+            reportStall(nowMs() - sentAt);
+        }
+    }
+}
+
+void Watchdog::acknowledge(qint64 sentAt)
+{
+    const qint64 latency = nowMs() - sentAt;
+    addSample(latency);
+    if (m_stallReported)
+        qWarning() << "Watchdog: GUI thread was blocked for" << latency << "ms in total";
+
+    m_pendingPing = -1;
+}
+
+void Watchdog::reportStall(qint64 blockedMs) const
+{
+    const QVector<Tracer::Operation> operations = Tracer::currentOperations();
+    if (operations.isEmpty()) {
+        qWarning() << "Watchdog: GUI thread blocked for" << blockedMs << "ms, outside any traced operation";
+        return;
+    }
+
+    const qint64 now = Tracer::now();
+    QStringList description;
+    for (const Tracer::Operation &operation : operations) {
+        QString text = QString::fromLatin1(operation.name);
+        if (!operation.args.isEmpty())
+            text += QStringLiteral("(\"%1\")").arg(operation.args);
+        text += QStringLiteral(" for %1 ms").arg((now - operation.start) / 1000);
+        description << text;
+    }
+
+    qWarning().noquote() << "Watchdog: GUI thread blocked for" << blockedMs << "ms in" << description.join(QStringLiteral(" > "));
+}
+
+int Watchdog::bucket(qint64 latencyMs)
+{
+    int index = 0;
+    for (qint64 limit = 1; latencyMs >= limit && index < NumBuckets - 1; limit *= 2)
+        ++index;
+
+    return index;
+}
+
+void Watchdog::addSample(qint64 latencyMs)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_samples.size() < WindowSize) {
+        m_samples.append(latencyMs);
+    } else {
+        m_buckets[bucket(m_samples.at(m_nextSample))]--;
+        m_samples[m_nextSample] = latencyMs;
+        m_nextSample = (m_nextSample + 1) % WindowSize;
+    }
+
+    m_buckets[bucket(latencyMs)]++;
+}
+
+QString Watchdog::report() const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList lines;
+    lines << QStringLiteral("Event loop latency, last %1 samples:").arg(m_samples.size());
+    if (m_samples.isEmpty())
+        return lines.first();
+
+    const int maxCount = *std::max_element(m_buckets.cbegin(), m_buckets.cend());
+    for (int i = 0; i < NumBuckets; ++i) {
+        const QString range = i == NumBuckets - 1 ? QStringLiteral(">= %1 ms").arg(1 << (i - 1))
+                                                  : QStringLiteral("< %1 ms").arg(1 << i);
+        const int count = m_buckets.at(i);
+        lines << QStringLiteral("  %1 %2 %3").arg(range, -10).arg(count, 7).arg(QString(count * 40 / qMax(1, maxCount), QLatin1Char('#')));
+    }
+
+    QVector<qint64> sorted = m_samples;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](int p) {
+        return sorted.at(qMin(sorted.size() - 1, sorted.size() * p / 100));
+    };
+    lines << QStringLiteral("  p50 %1 ms, p95 %2 ms, p99 %3 ms, max %4 ms")
+                 .arg(percentile(50))
+                 .arg(percentile(95))
+                 .arg(percentile(99))
+                 .arg(sorted.last());
+
+    return lines.join(QLatin1Char('\n'));
+}
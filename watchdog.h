@@ -0,0 +1,78 @@
+/*
+  Copyright (c) 2026 Sergio Martins <iamsergio@gmail.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+  As a special exception, permission is given to link this program
+  with any edition of Qt, and distribute the resulting executable,
+  without including the source code for Qt in the source distribution.
+*/
+
+#ifndef SNIPPY_WATCHDOG_H
+#define SNIPPY_WATCHDOG_H
+
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+#include <atomic>
+
+class QThread;
+
+// Pings the GUI event loop from a separate thread and measures how long the ping takes
+// to be processed. When it takes longer than the threshold the GUI thread is considered
+// stalled and the traced operations it's in are logged, see Tracer.
+// Latencies of the last samples are kept in a histogram, see report().
+// Enabled with SNIPPY_WATCHDOG_MS=<threshold>, --watchdog <threshold> or the Debug menu.
+
+class Watchdog : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Watchdog(QObject *parent = nullptr);
+    ~Watchdog() override;
+
+    void start(int thresholdMs);
+    void stop();
+    bool isRunning() const;
+
+    QString report() const; // Latency histogram and percentiles
+
+private:
+    enum {
+        PingIntervalMs = 20,
+        NumBuckets = 14, // < 1ms, < 2ms, < 4ms ... >= 4096ms
+        WindowSize = 10000 // Samples in the rolling histogram
+    };
+
+    void run();
+    void acknowledge(qint64 sentAt);
+    void addSample(qint64 latencyMs);
+    void reportStall(qint64 blockedMs) const;
+    static int bucket(qint64 latencyMs);
+
+    QThread *m_thread = nullptr;
+    std::atomic<bool> m_stopRequested;
+    std::atomic<qint64> m_pendingPing; // When the unanswered ping was sent, -1 if none
+    std::atomic<bool> m_stallReported;
+    int m_thresholdMs = 50;
+
+    mutable QMutex m_mutex; // For what's below
+    QVector<qint64> m_samples; // Ring buffer
+    int m_nextSample = 0;
+    QVector<int> m_buckets;
+};
+
+#endif